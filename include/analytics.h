@@ -0,0 +1,195 @@
+#pragma once
+#include "sales_types.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+using namespace std;
+
+// Метрики, которые можно включить в расчёт (итоги считаются всегда)
+enum MetricMask : unsigned {
+    METRIC_DAILY     = 1u << 0,     // Выручка по дням
+    METRIC_SKU       = 1u << 1,     // Выручка по артикулам
+    METRIC_HISTOGRAM = 1u << 2,     // Гистограмма сумм заказов
+    METRIC_APPROX_SKU = 1u << 3,    // Приблизительный топ артикулов (--approx)
+    METRIC_QUANTILES = 1u << 4,     // Квантили сумм заказов (p50, p90, p99)
+    METRIC_DISTINCT  = 1u << 5,     // Число разных заказов и артикулов (HyperLogLog)
+    METRICS_ALL      = METRIC_DAILY | METRIC_SKU | METRIC_HISTOGRAM | METRIC_QUANTILES | METRIC_DISTINCT
+};
+
+// Сколько всего масок метрик (для таблиц конвейеров)
+const unsigned METRIC_MASK_COUNT = 64;
+
+// Счётчиков приблизительного топа по умолчанию
+const size_t APPROX_TOP_DEFAULT_CAPACITY = 1024;
+
+// Счётчик приблизительного топа: настоящая выручка в [count - error, count]
+// (артикул хранится текстом: с --approx артикулы не заносятся в словарь)
+struct ApproxCounter {
+    string sku;
+    Money count;
+    Money error;
+};
+
+// Суммы одного артикула (16 байт): разреженная выручка по артикулам
+struct SkuTotal {
+    SkuId sku;
+    uint32_t lines;
+    Money revenue;
+};
+
+// Корзины гистограммы сумм заказов: верхние границы в копейках
+// (до 500, 1 000, 5 000, 10 000, 50 000, 100 000, 500 000 руб. и больше)
+const int ORDER_VALUE_BUCKETS = 8;
+constexpr Money ORDER_VALUE_BOUNDS[ORDER_VALUE_BUCKETS - 1] = {
+    50000, 100000, 500000, 1000000, 5000000, 10000000, 50000000
+};
+
+// Номер корзины для суммы заказа
+inline int order_value_bucket(Money order_total) {
+    int k = 0;
+    while (k < ORDER_VALUE_BUCKETS - 1 && order_total >= ORDER_VALUE_BOUNDS[k]) k++;
+    return k;
+}
+
+// Скетч квантилей сумм заказов с относительной погрешностью
+// QUANTILE_RELATIVE_ERROR (логарифмические корзины, как в DDSketch).
+// Сумма попадает в корзину k, если gamma^(k-1) < сумма <= gamma^k, где
+// gamma = (1 + e) / (1 - e); любая сумма корзины отличается от её середины
+// не больше чем на e. Скетчи сливаются сложением корзин, поэтому результат
+// не зависит от числа потоков, а сортировать все суммы не нужно
+const double QUANTILE_RELATIVE_ERROR = 0.01;
+
+struct QuantileSketch {
+    vector<long long> buckets;      // Корзина k лежит в buckets[k - min_key]
+    int min_key = 0;
+    long long zero_count = 0;       // Суммы <= 0 (отдельно: логарифма нет)
+    long long count = 0;
+};
+
+// Добавить сумму в скетч
+void sketch_add(QuantileSketch& sketch, Money value);
+
+// Слить другой скетч в sketch
+void sketch_merge(QuantileSketch& sketch, const QuantileSketch& other);
+
+// Квантиль q (0..1) по ближайшему рангу с точностью до QUANTILE_RELATIVE_ERROR
+Money sketch_quantile(const QuantileSketch& sketch, double q);
+
+// Процентили чека, которые попадают в отчёт
+const int CHECK_PERCENTILES[] = {50, 90, 99};
+
+// Оценка числа разных значений (HyperLogLog): 2^precision регистров по байту,
+// в регистре - наибольшая длина серии нулей среди хешей, попавших в него.
+// Стандартная погрешность 1.04 / sqrt(2^precision). Слияние - поэлементный
+// максимум регистров, поэтому оценка не зависит ни от числа потоков, ни от
+// того, по каким частям считались данные
+const int HLL_PRECISION = 14;           // Заказы и артикулы за всё время (~0.8%)
+const int HLL_DAILY_PRECISION = 12;     // Артикулы за день (~1.6%, 4 КБ на день)
+
+struct HyperLogLog {
+    int precision = 0;
+    vector<uint8_t> registers;          // Пусто - ещё ничего не добавлено
+};
+
+// 64-битный хеш строки для HyperLogLog (одинаковый в любом запуске)
+uint64_t distinct_hash(string_view text);
+
+// Добавить значение по его хешу
+void hll_add(HyperLogLog& hll, uint64_t hash, int precision = HLL_PRECISION);
+
+// Слить другой скетч в hll. При разной точности результат получает
+// меньшую из двух
+void hll_merge(HyperLogLog& hll, const HyperLogLog& other);
+
+// Оценка числа разных значений
+long long hll_estimate(const HyperLogLog& hll);
+
+// Результат расчёта (поля невыбранных метрик остаются пустыми)
+struct AnalyticsPart {
+    long long order_count = 0;              // Количество заказов
+    long long item_count = 0;               // Количество позиций
+    Money total_revenue = 0;                // Выручка
+    map<string, Money> daily_revenue;       // дата -> выручка
+    vector<Money> product_revenue;          // номер артикула -> выручка
+    vector<uint32_t> product_lines;         // номер артикула -> число позиций (0 - не встречался)
+    vector<pair<SkuId, Money>> product_top; // С --memory-limit: лучшие артикулы по убыванию выручки
+                                            // (product_revenue и product_lines тогда пусты)
+    vector<SkuTotal> product_totals;        // С --memory-limit и --emit-partial: только встречавшиеся
+                                            // артикулы, без порядка (вместо product_revenue)
+    vector<long long> order_value_histogram;    // корзина -> число заказов
+    vector<ApproxCounter> approx_top;       // Счётчики приблизительного топа (без порядка)
+    size_t approx_capacity = 0;             // Сколько счётчиков было доступно
+    QuantileSketch order_value_sketch;      // Квантили сумм заказов
+    HyperLogLog distinct_orders;            // Разные номера заказов
+    HyperLogLog distinct_skus;              // Разные артикулы
+    map<string, HyperLogLog> daily_distinct_skus;   // дата -> разные артикулы за день
+    long long spill_count = 0;              // Сбросов таблицы артикулов на диск (--memory-limit)
+    long long spilled_bytes = 0;
+};
+
+// Посчитать стоимость одного заказа
+Money calculate_order_total(const Order& order);
+
+// Получить дату из строки (YYYY-MM-DD)
+string get_date(const string& date_time);
+
+// Разделить сумму на количество с округлением до копейки
+Money divide_money(Money total, long long count);
+
+// Посчитать выбранные метрики за один проход: диапазоны заказов делятся
+// между потоками, частичные результаты сливаются попарным деревом.
+// Суммы целые, поэтому результат совпадает с однопоточным.
+// Для каждой комбинации metrics заранее собран свой конвейер (metrics_pipeline.h)
+// approx_capacity - число счётчиков для METRIC_APPROX_SKU.
+// memory_limit > 0 - выручка по артикулам считается отдельным проходом
+// в таблице с этим бюджетом байт, лишнее уходит на диск (spill_table.h),
+// и в итог попадают только top_count лучших артикулов (0 - все)
+AnalyticsPart aggregate_orders(const vector<Order>& orders, int threads = 1, unsigned metrics = METRICS_ALL,
+                               size_t approx_capacity = APPROX_TOP_DEFAULT_CAPACITY, size_t memory_limit = 0,
+                               int top_count = 0);
+
+struct SpillTable;
+
+// Порционный расчёт: заказы приходят пачками по мере загрузки.
+// Внутри тот же конвейер, что и в aggregate_orders, для маски metrics
+struct AnalyticsAccumulator {
+    unsigned metrics = METRICS_ALL;
+    size_t approx_capacity = APPROX_TOP_DEFAULT_CAPACITY;
+    shared_ptr<void> state;
+    shared_ptr<SpillTable> spill;   // Выручка по артикулам при лимите памяти
+};
+
+// Создать пустой накопитель для выбранных метрик
+AnalyticsAccumulator make_accumulator(unsigned metrics = METRICS_ALL,
+                                      size_t approx_capacity = APPROX_TOP_DEFAULT_CAPACITY,
+                                      size_t memory_limit = 0, int top_count = 0);
+
+// Учесть заказы [begin, end) (словарь артикулов мог вырасти - таблицы расширяются)
+void accumulate_orders(AnalyticsAccumulator& acc, const vector<Order>& orders, size_t begin, size_t end);
+
+// Забрать результат (накопитель после этого пуст)
+AnalyticsPart finish_accumulator(AnalyticsAccumulator& acc);
+
+// Влить готовый результат part в result (например, части с разных узлов).
+// Итоги, дни, артикулы и гистограмма складываются, скетчи сливаются,
+// счётчики приблизительного топа - как при слиянии потоков
+void merge_analytics(AnalyticsPart& result, AnalyticsPart& part);
+
+// Топ товаров по выручке из готовых агрегатов (при равной выручке - по артикулу)
+vector<pair<string, Money>> top_products_from(const AnalyticsPart& part, int top_count);
+
+// Приблизительный топ из счётчиков Space-Saving (по оценке, при равенстве - по артикулу)
+vector<ApproxCounter> approx_top_products(const AnalyticsPart& part, int top_count);
+
+// Посчитать выручку по дням
+map<string, Money> calculate_daily_revenue(const vector<Order>& orders, int threads = 1);
+
+// Посчитать средний чек
+Money calculate_average_check(const vector<Order>& orders, int threads = 1);
+
+// Найти топ товаров по выручке
+vector<pair<string, Money>> find_top_products(const vector<Order>& orders, int top_count, int threads = 1);
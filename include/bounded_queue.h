@@ -0,0 +1,63 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstddef>
+
+using namespace std;
+
+// Очередь ограниченной ёмкости между потоками.
+// push ждёт, пока освободится место (так быстрый поставщик не уходит
+// далеко вперёд), pop ждёт элемент. После close() push отказывает,
+// а pop отдаёт оставшееся и затем возвращает false.
+// Время ожидания добавляется в wait_us, чтобы считать простой стадий
+template <typename T>
+struct BoundedQueue {
+    size_t capacity;
+    deque<T> items;
+    bool closed = false;
+    mutex lock;
+    condition_variable not_empty;
+    condition_variable not_full;
+
+    explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    bool push(T&& item, long long& wait_us) {
+        unique_lock<mutex> guard(lock);
+        if (items.size() >= capacity && !closed) {
+            auto start = chrono::steady_clock::now();
+            not_full.wait(guard, [this]() { return items.size() < capacity || closed; });
+            wait_us += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        }
+        if (closed) return false;
+        items.push_back(move(item));
+        guard.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item, long long& wait_us) {
+        unique_lock<mutex> guard(lock);
+        if (items.empty() && !closed) {
+            auto start = chrono::steady_clock::now();
+            not_empty.wait(guard, [this]() { return !items.empty() || closed; });
+            wait_us += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        }
+        if (items.empty()) return false;
+        item = move(items.front());
+        items.pop_front();
+        guard.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> guard(lock);
+            closed = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include "sales_types.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+
+using namespace std;
+
+// ========== ПОВТОРНЫЕ ЗАКАЗЫ ==========
+//
+// Один и тот же заказ может прийти в нескольких файлах (источник повторно
+// выгружает файлы), и тогда выручка считается дважды. Заказы сверяются по
+// номеру. Номер вида "ORD000123" кодируется в одно 64-битное число и
+// хранится в открытой хеш-таблице (8 байт на заказ), остальные номера -
+// строками. Для экономии памяти можно включить фильтр Блума: первый проход
+// держит только биты фильтра и отбирает номера, которые "возможно уже были",
+// второй точно сверяет лишь эти номера.
+
+enum DedupMode {
+    DEDUP_OFF,          // Не проверять
+    DEDUP_REPORT,       // Только сообщить о повторах
+    DEDUP_FIRST,        // Оставить первый по порядку файлов
+    DEDUP_LAST          // Оставить последний по порядку файлов
+};
+
+struct DedupOptions {
+    DedupMode mode = DEDUP_OFF;
+    bool bloom = false;         // Фильтр Блума перед точной проверкой
+};
+
+// Можно ли отсеять повторы одним проходом по ходу загрузки: report и drop
+// без фильтра Блума (last и фильтр Блума смотрят на все заказы сразу)
+bool dedup_streams(const DedupOptions& options);
+
+// Сколько повторных номеров показывать в отчёте
+const size_t DEDUP_EXAMPLES = 10;
+
+// Фильтр Блума: бит на номер и число хешей (ложных срабатываний около 1%)
+const size_t BLOOM_BITS_PER_ID = 10;
+const int BLOOM_HASHES = 7;
+
+struct DedupStats {
+    long long checked = 0;          // Заказов с номером
+    long long duplicates = 0;       // Повторных вхождений
+    long long removed = 0;          // Из них удалено
+    long long candidates = 0;       // Номеров после фильтра Блума
+    size_t memory_bytes = 0;        // Память под проверку
+    vector<string> examples;        // Первые повторные номера
+};
+
+// Разобрать название режима (report, drop, last)
+bool parse_dedup_mode(const string& name, DedupMode& mode);
+
+// Закодировать номер вида "ORD000123" (до 3 латинских букв и до 13 цифр)
+// в число. false - номер другого вида
+bool encode_order_id(string_view id, uint64_t& key);
+
+// Множество номеров заказов
+struct OrderIdSet {
+    vector<uint64_t> slots;             // Закодированные номера, 0 - пусто
+    size_t used = 0;
+    unordered_set<string> other;        // Номера, которые не кодируются
+
+    // Добавить номер. false - такой уже был
+    bool insert(const string& id);
+
+    // Есть ли номер (без добавления)
+    bool contains(const string& id) const;
+
+    size_t memory_bytes() const;
+};
+
+// Найти повторы в orders (порядок заказов - порядок файлов) и,
+// в зависимости от режима, удалить лишние вхождения
+DedupStats deduplicate_orders(vector<Order>& orders, const DedupOptions& options);
+
+// Вывести итог проверки
+void print_dedup_stats(const DedupStats& stats, const DedupOptions& options);
@@ -3,8 +3,47 @@
 
 using namespace std;
 
+// Распределение целого числа (позиций в заказе, количества товара)
+enum CountKind {
+    COUNT_UNIFORM,      // Равномерно от min до max
+    COUNT_GEOMETRIC     // min + геометрическое: малые значения часты, длинный хвост до max
+};
+
+struct CountDistribution {
+    CountKind kind = COUNT_UNIFORM;
+    int min = 1;
+    int max = 10;
+    double mean = 0;    // Среднее для COUNT_GEOMETRIC
+};
+
+// Каталог по умолчанию для --zipf без --catalog
+const int ZIPF_DEFAULT_CATALOG = 100000;
+
+// С --seed последний день периода - не сегодня, а 2026-01-01 (UTC); здесь
+// его начало, 00:00. Метки этого дня идут до 23:59. Иначе при том же
+// зерне даты сдвигались бы с каждым днём
+const long long GENERATOR_SEED_LAST_DAY = 1767225600;
+
+// Параметры генерации. По умолчанию - прежние равномерные данные:
+// случайные артикулы, 1-10 позиций, количество 1-50, последние 30 дней
+struct GeneratorOptions {
+    bool with_errors = false;
+    int catalog_size = 0;               // Артикулов в каталоге (0 - случайные артикулы)
+    double zipf_exponent = 0;           // > 0 - популярность артикулов каталога по закону Ципфа
+    CountDistribution items{COUNT_UNIFORM, 1, 10, 0};       // Позиций в заказе
+    CountDistribution quantity{COUNT_UNIFORM, 1, 50, 0};    // Количество в позиции
+    int days = 30;                      // Период: последние days дней (с seed - по GENERATOR_SEED_LAST_DAY)
+    bool seasonality = false;           // Профиль по дням недели и часам вместо равномерного
+    unsigned seed = 0;                  // Зерно генератора (0 - случайное)
+};
+
+// Разобрать "A-B" (равномерно, 1 <= A <= B) или "geom:СРЕДНЕЕ[:МАКС]" (минимум - dist.min).
+// false - ошибка формата
+bool parse_count_distribution(const string& spec, CountDistribution& dist);
+
 // Генерация отдельных JSON файлов
 void generate_separate_files(const string& base_dir, int count, bool with_errors = false);
+void generate_separate_files(const string& base_dir, int count, const GeneratorOptions& options);
 
 // CLI-генератор (если нужен)
-void generateJSON(int argc, char* argv[]);
\ No newline at end of file
+void generateJSON(int argc, char* argv[]);
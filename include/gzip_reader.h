@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+
+using namespace std;
+
+// ========== ЧТЕНИЕ ФАЙЛОВ, СЖАТЫХ GZIP ==========
+//
+// Заказы могут лежать в архивах .json.gz. Такие файлы распаковываются
+// в памяти (zlib) прямо в текст для парсера, без временных файлов.
+// Сжат ли файл, определяется по первым байтам, а не по имени.
+
+// Начинается ли содержимое с подписи gzip (1f 8b)
+bool is_gzip(const string& data);
+
+// Распаковать gzip (в том числе несколько склеенных частей) в text.
+// false - данные повреждены
+bool gunzip(const string& compressed, string& text);
+
+// Прочитать файл целиком; сжатый gzip распаковывается по ходу чтения.
+// false - файл не открылся или повреждён
+bool read_text_file(const string& path, string& text);
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Файл с заказами по имени (.json, сжатый .json.gz или сегмент .oseg)
+bool is_orders_file(const string& filename);
+
+// Собрать файлы с заказами по списку входов (--input).
+// Вход - файл, директория или шаблон с * ? [ ] (раскрывается через glob).
+// Директории обходятся рекурсивно в threads потоков; из них берутся только
+// файлы с заказами, а явно указанный файл берётся всегда.
+// Файлы каждого входа идут по порядку путей, повторы убираются.
+// Для входов, которые ничего не нашли, выводится предупреждение
+vector<string> collect_input_files(const vector<string>& inputs, int threads);
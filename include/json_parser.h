@@ -0,0 +1,34 @@
+#pragma once
+#include "sales_types.h"
+#include "json_schema.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Убрать пробелы в начале строки
+void skip_spaces(const string& text, int& position);
+
+// Прочитать строку из JSON (в кавычках)
+string read_json_string(const string& text, int& position);
+
+// Прочитать число из JSON
+double read_json_number(const string& text, int& position);
+
+// Прочитать денежную сумму из JSON сразу в копейки (без double)
+Money read_json_money(const string& text, int& position);
+
+// Прочитать артикул и сразу занести в словарь
+SkuId read_json_sku(const string& text, int& position);
+
+// Пропустить любое JSON-значение
+void skip_json_value(const string& text, int& position);
+
+// Прочитать один товар из JSON (только поля из options.fields)
+Item read_json_item(const string& text, int& position, const ParseOptions& options = ParseOptions());
+
+// Прочитать один заказ из JSON
+Order read_json_order(const string& text, int& position, const ParseOptions& options = ParseOptions());
+
+// Прочитать все заказы из JSON (заказы вне периода options пропускаются)
+vector<Order> read_json(const string& text, const ParseOptions& options = ParseOptions());
@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+using namespace std;
+
+// ========== СХЕМА JSON-ОБЪЕКТА, СОБИРАЕМАЯ ПРИ КОМПИЛЯЦИИ ==========
+//
+// Объект (Item, Order) описывается массивом полей: имя + функция чтения
+// значения. По этому описанию при компиляции строится совершенная хеш-таблица
+// (длина имени + первые два байта), и парсер находит поле одним обращением
+// к таблице, без выделения памяти под имя и без цепочки сравнений строк.
+// Чтобы добавить поле, достаточно добавить строку в описание схемы.
+
+// Биты полей заказа для проекции: парсер читает только отмеченные поля,
+// остальные пропускает без разбора и без выделения памяти
+enum FieldMask : unsigned {
+    FIELD_ID    = 1u << 0,
+    FIELD_TS    = 1u << 1,
+    FIELD_SKU   = 1u << 2,
+    FIELD_QTY   = 1u << 3,
+    FIELD_PRICE = 1u << 4,
+    FIELDS_ITEM = FIELD_SKU | FIELD_QTY | FIELD_PRICE,
+    FIELDS_ALL  = FIELD_ID | FIELD_TS | FIELDS_ITEM
+};
+
+// Что читать парсеру
+struct ParseOptions {
+    unsigned fields = FIELDS_ALL;   // Маска нужных полей
+    string date_from;               // Только заказы с этой даты (YYYY-MM-DD, пусто - без границы)
+    string date_to;                 // Только заказы по эту дату включительно
+    bool intern_skus = true;        // Артикулы в общий словарь (false - текстом в Order::sku_text)
+};
+
+// Попадает ли дата заказа в период options (сравниваются первые 10 символов)
+inline bool date_in_range(const string& date_time, const ParseOptions& options) {
+    if (!options.date_from.empty() && date_time.compare(0, 10, options.date_from) < 0) return false;
+    if (!options.date_to.empty() && date_time.compare(0, 10, options.date_to) > 0) return false;
+    return true;
+}
+
+// Функции чтения, нужные шаблону (реализованы в json_parser.cpp)
+void skip_spaces(const string& text, int& position);
+void skip_json_value(const string& text, int& position);
+
+// Одно поле схемы: имя, биты проекции (поле читается, если хоть один бит
+// запрошен) и функция чтения значения. Функция возвращает false, если по
+// значению видно, что объект не нужен (например, дата вне периода)
+template <typename Object>
+struct FieldDescriptor {
+    const char* name;
+    unsigned mask;
+    bool (*read)(const string& text, int& position, Object& object, const ParseOptions& options);
+};
+
+// Длина строки при компиляции
+constexpr size_t schema_name_length(const char* name) {
+    size_t n = 0;
+    while (name[n] != '\0') n++;
+    return n;
+}
+
+// Хеш имени поля: длина и первые два байта (для имён длиной 1 - байт дважды)
+constexpr uint32_t schema_hash(size_t length, unsigned char c0, unsigned char c1, uint32_t seed) {
+    uint32_t key = ((uint32_t)length << 16) | ((uint32_t)c0 << 8) | c1;
+    return (key * seed) >> 27;   // 5 бит: таблица на 32 слота
+}
+
+const size_t SCHEMA_TABLE_SIZE = 32;
+
+// Готовая схема: поля + таблица слот -> номер поля (-1 - пусто)
+template <typename Object, size_t N>
+struct Schema {
+    array<FieldDescriptor<Object>, N> fields;
+    array<size_t, N> lengths;
+    array<int8_t, SCHEMA_TABLE_SIZE> slots;
+    uint32_t seed;
+
+    // Номер поля по имени из текста или -1, если поле не из схемы
+    int find(const char* name, size_t length) const {
+        if (length == 0) return -1;
+        unsigned char c0 = (unsigned char)name[0];
+        unsigned char c1 = (unsigned char)name[length > 1 ? 1 : 0];
+        int index = slots[schema_hash(length, c0, c1, seed)];
+
+        // Один memcmp отсеивает посторонние поля с тем же хешем
+        if (index < 0 || lengths[index] != length) return -1;
+        if (memcmp(fields[index].name, name, length) != 0) return -1;
+        return index;
+    }
+};
+
+// Построить схему: подобрать множитель хеша без коллизий.
+// Если подобрать не удалось, constexpr-вычисление падает и сборка не проходит
+template <typename Object, size_t N>
+constexpr Schema<Object, N> make_schema(const FieldDescriptor<Object> (&fields)[N]) {
+    static_assert(N <= SCHEMA_TABLE_SIZE / 2, "слишком много полей для таблицы схемы");
+
+    Schema<Object, N> schema{};
+    for (size_t i = 0; i < N; i++) {
+        schema.fields[i] = fields[i];
+        schema.lengths[i] = schema_name_length(fields[i].name);
+    }
+
+    for (uint32_t seed = 0x9E3779B1u; seed < 0x9E3779B1u + 100000u; seed += 2) {
+        array<int8_t, SCHEMA_TABLE_SIZE> slots{};
+        for (size_t k = 0; k < SCHEMA_TABLE_SIZE; k++) slots[k] = -1;
+
+        bool ok = true;
+        for (size_t i = 0; i < N && ok; i++) {
+            const char* name = fields[i].name;
+            size_t length = schema.lengths[i];
+            unsigned char c1 = (unsigned char)name[length > 1 ? 1 : 0];
+            uint32_t slot = schema_hash(length, (unsigned char)name[0], c1, seed);
+            if (slots[slot] >= 0) ok = false;
+            else slots[slot] = (int8_t)i;
+        }
+
+        if (ok) {
+            schema.slots = slots;
+            schema.seed = seed;
+            return schema;
+        }
+    }
+
+    throw "не удалось построить совершенный хеш для схемы";
+}
+
+// Прочитать JSON-объект { "поле": значение, ... } по схеме.
+// Поля не из схемы и не попавшие в проекцию пропускаются целиком.
+// Если поле отвергло объект, остальные поля тоже только пропускаются,
+// а функция возвращает false
+template <typename Object, size_t N>
+bool read_object(const Schema<Object, N>& schema, const string& text, int& position, Object& object,
+                 const ParseOptions& options) {
+    skip_spaces(text, position);
+    position++; // Пропускаем {
+    bool accepted = true;
+
+    while (position < (int)text.length() && text[position] != '}') {
+        skip_spaces(text, position);
+
+        if (text[position] == ',') {
+            position++;
+            continue;
+        }
+
+        if (text[position] == '}') break;
+
+        // Имя поля берём прямо из текста (имена схемы без экранирования)
+        position++; // Пропускаем "
+        int name_start = position;
+        while (position < (int)text.length() && text[position] != '"') {
+            if (text[position] == '\\') position++;
+            position++;
+        }
+        int field = schema.find(text.data() + name_start, position - name_start);
+        position++; // Пропускаем "
+
+        skip_spaces(text, position);
+        position++; // Пропускаем :
+
+        if (accepted && field >= 0 && (schema.fields[field].mask & options.fields) != 0) {
+            accepted = schema.fields[field].read(text, position, object, options);
+        }
+        else {
+            skip_json_value(text, position);
+        }
+    }
+
+    position++; // Пропускаем }
+    return accepted;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "sales_types.h"
+#include "json_schema.h"
+#include "analytics.h"
+#include "dedup.h"
+#include "validation.h"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ========== КОНВЕЙЕР ЗАГРУЗКИ: ЧТЕНИЕ -> РАЗБОР -> РАСЧЁТ ==========
+//
+// Чтение (один поток, io_uring или обычное) кладёт содержимое файлов
+// в очередь, потоки разбора превращают его в заказы (сжатые gzip файлы
+// сначала распаковываются там же), расчёт забирает
+// пачки заказов строго по порядку файлов и сразу считает метрики.
+// Повторные заказы (режимы report и drop без фильтра Блума) отсеиваются
+// там же, до расчёта; остальные режимы проверяются после загрузки, и
+// метрики пересчитываются, только если что-то удалено.
+// Одновременно в работе не больше buffers файлов: чтение ждёт, пока
+// расчёт не заберёт самый старый, поэтому память ограничена
+// независимо от размера директории.
+// Без keep_orders заказы не накапливаются вовсе: каждая пачка
+// проверяется и учитывается в метриках, после чего выбрасывается
+// (вместе с memory_limit - для машин, где все заказы не помещаются в память).
+
+// Файлов в работе по умолчанию
+const size_t LOAD_DEFAULT_BUFFERS = 64;
+
+struct LoadOptions {
+    ParseOptions parse;                 // Какие поля читать
+    unsigned metrics = METRICS_ALL;     // Какие метрики считать на лету
+    int parser_threads = 1;             // Потоков разбора
+    size_t buffers = LOAD_DEFAULT_BUFFERS;  // Файлов в работе одновременно
+    bool use_uring = true;              // Читать через io_uring (если есть)
+    bool show_progress = true;          // Печатать прогресс каждые 10%
+    size_t approx_capacity = APPROX_TOP_DEFAULT_CAPACITY;  // Счётчиков для METRIC_APPROX_SKU
+    DedupOptions dedup;                 // Проверка повторных заказов
+    size_t memory_limit = 0;            // Бюджет выручки по артикулам, байт (0 - без лимита)
+    int top_count = 0;                  // С memory_limit: сколько лучших артикулов оставить (0 - все)
+    bool keep_orders = true;            // Хранить заказы в LoadResult::orders
+    ValidationOptions validation;       // Проверка по ходу загрузки (только без keep_orders)
+};
+
+// Загрузка одной стадии: сколько работала и сколько простаивала
+struct StageStats {
+    string name;
+    int workers = 1;
+    long long busy_us = 0;          // Полезная работа (сумма по потокам)
+    long long wait_input_us = 0;    // Ждали данных от предыдущей стадии
+    long long wait_output_us = 0;   // Ждали места в очереди следующей стадии
+    long long items = 0;            // Обработано файлов
+};
+
+struct LoadResult {
+    vector<Order> orders;           // Заказы в порядке файлов (если keep_orders)
+    long long order_count = 0;      // Загружено заказов
+    AnalyticsPart analytics;        // Метрики LoadOptions::metrics по этим заказам
+    vector<StageStats> stages;      // Чтение, распаковка (если были .gz), разбор, расчёт
+    long long wall_us = 0;          // Время работы конвейера
+    size_t peak_buffers = 0;        // Наибольшее число файлов в работе
+    DedupStats dedup;               // Итог проверки повторов (если включена)
+    ValidationResult validation{};  // Итог проверки (без keep_orders)
+    map<size_t, Order> error_orders;    // Заказы из образца ошибок (без keep_orders)
+};
+
+// Загрузить файлы paths через конвейер
+LoadResult load_files(const vector<string>& paths, const LoadOptions& options);
+
+// Загрузка стадий (занятость в % от времени конвейера)
+void print_load_stats(const LoadResult& result);
@@ -0,0 +1,489 @@
+#pragma once
+#include "analytics.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <algorithm>
+#include <unordered_map>
+#include <string_view>
+#include <functional>
+
+using namespace std;
+
+// ========== КОНВЕЙЕР МЕТРИК, СОБИРАЕМЫЙ ПРИ КОМПИЛЯЦИИ ==========
+//
+// Каждая метрика - компонент с одинаковым набором методов:
+//   init(setup)                - подготовить таблицы (повторный вызов
+//                                с большим setup.sku_total их расширяет)
+//   add_item(item, revenue)    - учесть позицию заказа
+//   add_order(order, total)    - учесть заказ целиком
+//   merge(other)               - влить результат другого потока
+//   export_to(result)          - перенести результат в AnalyticsPart
+// MetricPipeline<A, B, ...> наследует выбранные компоненты и вызывает их
+// методы свёрткой. Пустые методы не выбранных метрик встраиваются в ничто,
+// поэтому, например, без SkuMetric на позицию не тратится ни одной операции
+// с таблицей артикулов.
+
+// Параметры для init
+struct MetricSetup {
+    size_t sku_total = 0;           // Размер словаря артикулов
+    size_t approx_capacity = APPROX_TOP_DEFAULT_CAPACITY;  // Счётчиков у ApproxSkuMetric
+};
+
+// Итоги: заказы, позиции, выручка (нужны всегда)
+struct TotalsMetric {
+    long long order_count = 0;
+    long long item_count = 0;
+    Money total_revenue = 0;
+
+    void init(const MetricSetup&) {}
+    void add_item(const Item&, Money) {}
+
+    void add_order(const Order& order, Money order_total) {
+        order_count++;
+        item_count += order.items.size();
+        total_revenue += order_total;
+    }
+
+    void merge(TotalsMetric& other) {
+        order_count += other.order_count;
+        item_count += other.item_count;
+        total_revenue += other.total_revenue;
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.order_count = order_count;
+        result.item_count = item_count;
+        result.total_revenue = total_revenue;
+    }
+};
+
+// Выручка по дням
+struct DailyMetric {
+    map<string, Money> daily_revenue;
+
+    void init(const MetricSetup&) {}
+    void add_item(const Item&, Money) {}
+
+    void add_order(const Order& order, Money order_total) {
+        daily_revenue[get_date(order.date_time)] += order_total;
+    }
+
+    void merge(DailyMetric& other) {
+        for (auto& p : other.daily_revenue) {
+            daily_revenue[p.first] += p.second;
+        }
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.daily_revenue = move(daily_revenue);
+    }
+};
+
+// Выручка по артикулам. Поток видит лишь часть словаря, поэтому суммы
+// лежат в компактной хеш-таблице по встреченным артикулам (открытая
+// адресация, линейное пробирование): память и слияние пропорциональны
+// числу встреченных артикулов, а не размеру словаря. Плотные массивы
+// строятся один раз в export_to
+struct SkuMetric {
+    vector<uint32_t> keys;          // Номер артикула + 1, 0 - пусто
+    vector<Money> revenue;
+    vector<uint32_t> lines;
+    size_t used = 0;                // Занятых ячеек
+    size_t sku_total = 0;           // Размер словаря для export_to
+
+    // Словарь между порциями только растёт: накопленное сохраняется
+    void init(const MetricSetup& setup) {
+        sku_total = max(sku_total, setup.sku_total);
+    }
+
+    void add_item(const Item& item, Money item_revenue) {
+        size_t k = slot(item.sku);
+        revenue[k] += item_revenue;
+        lines[k]++;
+    }
+
+    void add_order(const Order&, Money) {}
+
+    // Обходим только занятые ячейки другой таблицы
+    void merge(SkuMetric& other) {
+        sku_total = max(sku_total, other.sku_total);
+        for (size_t j = 0; j < other.keys.size(); j++) {
+            if (other.keys[j] == 0) continue;
+            size_t k = slot(other.keys[j] - 1);
+            revenue[k] += other.revenue[j];
+            lines[k] += other.lines[j];
+        }
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.product_revenue.assign(sku_total, 0);
+        result.product_lines.assign(sku_total, 0);
+        for (size_t j = 0; j < keys.size(); j++) {
+            if (keys[j] == 0) continue;
+            result.product_revenue[keys[j] - 1] += revenue[j];
+            result.product_lines[keys[j] - 1] += lines[j];
+        }
+        *this = SkuMetric();
+    }
+
+    // Ячейка артикула; новую заводим с нулевыми суммами.
+    // Заполненность держим не выше 3/4
+    size_t slot(SkuId sku) {
+        if ((used + 1) * 4 > keys.size() * 3) grow();
+        size_t mask = keys.size() - 1;
+        size_t k = (sku * 0x9E3779B1u) & mask;
+        while (keys[k] != 0 && keys[k] != sku + 1) {
+            k = (k + 1) & mask;
+        }
+        if (keys[k] == 0) {
+            keys[k] = sku + 1;
+            used++;
+        }
+        return k;
+    }
+
+    void grow() {
+        vector<uint32_t> old_keys = move(keys);
+        vector<Money> old_revenue = move(revenue);
+        vector<uint32_t> old_lines = move(lines);
+        size_t capacity = max<size_t>(64, old_keys.size() * 2);
+        keys.assign(capacity, 0);
+        revenue.assign(capacity, 0);
+        lines.assign(capacity, 0);
+        used = 0;
+        for (size_t j = 0; j < old_keys.size(); j++) {
+            if (old_keys[j] == 0) continue;
+            size_t k = slot(old_keys[j] - 1);
+            revenue[k] = old_revenue[j];
+            lines[k] = old_lines[j];
+        }
+    }
+};
+
+// Гистограмма сумм заказов по корзинам ORDER_VALUE_BOUNDS
+struct HistogramMetric {
+    long long counts[ORDER_VALUE_BUCKETS] = {};
+
+    void init(const MetricSetup&) {}
+    void add_item(const Item&, Money) {}
+
+    void add_order(const Order&, Money order_total) {
+        counts[order_value_bucket(order_total)]++;
+    }
+
+    void merge(HistogramMetric& other) {
+        for (int k = 0; k < ORDER_VALUE_BUCKETS; k++) {
+            counts[k] += other.counts[k];
+        }
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.order_value_histogram.assign(counts, counts + ORDER_VALUE_BUCKETS);
+    }
+};
+
+// Квантили сумм заказов (скетч из analytics.h)
+struct QuantileMetric {
+    QuantileSketch sketch;
+
+    void init(const MetricSetup&) {}
+    void add_item(const Item&, Money) {}
+
+    void add_order(const Order&, Money order_total) {
+        sketch_add(sketch, order_total);
+    }
+
+    void merge(QuantileMetric& other) {
+        sketch_merge(sketch, other.sketch);
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.order_value_sketch = move(sketch);
+    }
+};
+
+// Число разных заказов и артикулов (за всё время и по дням)
+struct DistinctMetric {
+    HyperLogLog orders;
+    HyperLogLog skus;
+    map<string, HyperLogLog> daily_skus;
+    vector<uint64_t> sku_hashes;    // Хеш текста артикула по номеру
+
+    // Хеш считается по тексту артикула, а не по номеру: номера зависят
+    // от порядка загрузки, и скетчи разных запусков иначе не сольются
+    void init(const MetricSetup& setup) {
+        for (size_t k = sku_hashes.size(); k < setup.sku_total; k++) {
+            sku_hashes.push_back(distinct_hash(sku_name((SkuId)k)));
+        }
+    }
+
+    // Артикулы без словаря (Item::sku_offset) хешируются по тексту заказа
+    uint64_t sku_hash(const Order& order, const Item& item) const {
+        return item.sku_offset != 0 ? distinct_hash(item_sku(order, item)) : sku_hashes[item.sku];
+    }
+
+    void add_item(const Item&, Money) {}
+
+    void add_order(const Order& order, Money) {
+        if (!order.id.empty()) hll_add(orders, distinct_hash(order.id));
+
+        HyperLogLog* day = order.date_time.empty() ? nullptr : &daily_skus[get_date(order.date_time)];
+        for (const Item& item : order.items) {
+            if (!item_has_sku(item)) continue;
+            uint64_t hash = sku_hash(order, item);
+            hll_add(skus, hash);
+            if (day != nullptr) hll_add(*day, hash, HLL_DAILY_PRECISION);
+        }
+    }
+
+    void merge(DistinctMetric& other) {
+        hll_merge(orders, other.orders);
+        hll_merge(skus, other.skus);
+        for (auto& p : other.daily_skus) {
+            hll_merge(daily_skus[p.first], p.second);
+        }
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.distinct_orders = move(orders);
+        result.distinct_skus = move(skus);
+        result.daily_distinct_skus = move(daily_skus);
+    }
+};
+
+// Приблизительный топ артикулов по выручке (Space-Saving): не больше
+// capacity счётчиков, сколько бы артикулов ни было. Счётчик хранит оценку
+// выручки (не меньше настоящей) и погрешность: настоящая выручка лежит
+// в [count - error, count]. Минимальный счётчик - в корне кучи; новый
+// артикул при полной таблице занимает его место и наследует его значение.
+// Счётчики ведутся по тексту артикула: с --approx словарь не заполняется
+struct ApproxSkuMetric {
+    // Поиск по string_view без временной строки
+    struct TextHash {
+        using is_transparent = void;
+        size_t operator()(string_view text) const { return hash<string_view>()(text); }
+    };
+
+    size_t capacity = 0;
+    vector<ApproxCounter> heap;                 // Куча по возрастанию count
+    unordered_map<string, size_t, TextHash, equal_to<>> position;  // артикул -> место в куче
+
+    void init(const MetricSetup& setup) {
+        if (capacity == 0) {
+            capacity = max<size_t>(1, setup.approx_capacity);
+            heap.reserve(capacity);
+            position.reserve(capacity * 2);
+        }
+    }
+
+    // Счётчики переставляются обменом: строки артикулов не копируются
+    void swap_places(size_t i, size_t j) {
+        swap(heap[i], heap[j]);
+        position.find(heap[i].sku)->second = i;
+        position.find(heap[j].sku)->second = j;
+    }
+
+    void sift_up(size_t i) {
+        while (i > 0 && heap[i].count < heap[(i - 1) / 2].count) {
+            swap_places(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+    void sift_down(size_t i) {
+        while (true) {
+            size_t child = i * 2 + 1;
+            if (child >= heap.size()) break;
+            if (child + 1 < heap.size() && heap[child + 1].count < heap[child].count) child++;
+            if (heap[child].count >= heap[i].count) break;
+            swap_places(i, child);
+            i = child;
+        }
+    }
+
+    // Добавить счётчик в кучу
+    void push(ApproxCounter counter) {
+        position[counter.sku] = heap.size();
+        heap.push_back(move(counter));
+        sift_up(heap.size() - 1);
+    }
+
+    // Учесть выручку weight артикула sku (error - погрешность, пришедшая с ней)
+    void offer(string_view sku, Money weight, Money error) {
+        auto it = position.find(sku);
+        if (it != position.end()) {
+            size_t i = it->second;
+            heap[i].count += weight;
+            heap[i].error += error;
+            sift_down(i);
+        }
+        else if (heap.size() < capacity) {
+            push(ApproxCounter{string(sku), weight, error});
+        }
+        else {
+            // Вытесняем минимальный счётчик
+            ApproxCounter& smallest = heap[0];
+            position.erase(smallest.sku);
+            smallest.sku.assign(sku);
+            smallest.error = smallest.count + error;
+            smallest.count += weight;
+            position[smallest.sku] = 0;
+            sift_down(0);
+        }
+    }
+
+    // Наименьший счётчик (0, пока таблица не заполнена: отсутствующий
+    // артикул тогда точно не встречался)
+    Money floor_count() const {
+        return heap.size() < capacity ? 0 : heap[0].count;
+    }
+
+    void add_item(const Item&, Money) {}
+
+    void add_order(const Order& order, Money) {
+        for (const Item& item : order.items) {
+            offer(item_sku(order, item), (Money)item.quantity * item.price, 0);
+        }
+    }
+
+    // Слияние сводок: артикул, которого нет в одной из них, мог там иметь
+    // выручку до её минимального счётчика - он добавляется к оценке и погрешности
+    void merge(ApproxSkuMetric& other) {
+        Money floor_a = floor_count();
+        Money floor_b = other.floor_count();
+
+        vector<ApproxCounter> all;
+        for (const ApproxCounter& a : heap) {
+            auto it = other.position.find(a.sku);
+            if (it != other.position.end()) {
+                const ApproxCounter& b = other.heap[it->second];
+                all.push_back(ApproxCounter{a.sku, a.count + b.count, a.error + b.error});
+            } else {
+                all.push_back(ApproxCounter{a.sku, a.count + floor_b, a.error + floor_b});
+            }
+        }
+        for (const ApproxCounter& b : other.heap) {
+            if (position.find(b.sku) == position.end()) {
+                all.push_back(ApproxCounter{b.sku, b.count + floor_a, b.error + floor_a});
+            }
+        }
+
+        // Остаются capacity наибольших
+        if (all.size() > capacity) {
+            nth_element(all.begin(), all.begin() + capacity, all.end(),
+                        [](const ApproxCounter& x, const ApproxCounter& y) { return x.count > y.count; });
+            all.resize(capacity);
+        }
+
+        heap.clear();
+        position.clear();
+        for (ApproxCounter& c : all) {
+            push(move(c));
+        }
+    }
+
+    void export_to(AnalyticsPart& result) {
+        result.approx_top = heap;
+        result.approx_capacity = capacity;
+    }
+};
+
+// Заглушка на месте невыбранной метрики (Tag делает заглушки разными типами)
+template <int Tag>
+struct NoMetric {
+    void init(const MetricSetup&) {}
+    void add_item(const Item&, Money) {}
+    void add_order(const Order&, Money) {}
+    void merge(NoMetric&) {}
+    void export_to(AnalyticsPart&) {}
+};
+
+// Конвейер из выбранных метрик
+template <typename... Metrics>
+struct MetricPipeline : Metrics... {
+    void init(const MetricSetup& setup) {
+        (Metrics::init(setup), ...);
+    }
+
+    // Один проход по заказам [begin, end)
+    void add_range(const vector<Order>& orders, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const Order& order = orders[i];
+            Money order_total = 0;
+
+            for (const Item& item : order.items) {
+                Money revenue = (Money)item.quantity * item.price;
+                order_total += revenue;
+                (Metrics::add_item(item, revenue), ...);
+            }
+
+            (Metrics::add_order(order, order_total), ...);
+        }
+    }
+
+    void merge(MetricPipeline& other) {
+        (Metrics::merge(static_cast<Metrics&>(other)), ...);
+    }
+
+    void export_to(AnalyticsPart& result) {
+        (Metrics::export_to(result), ...);
+    }
+};
+
+// Прогнать конвейер по заказам: диапазоны делятся между потоками,
+// частичные результаты сливаются попарным деревом
+template <typename Pipeline>
+AnalyticsPart run_pipeline(const vector<Order>& orders, int threads, size_t approx_capacity) {
+    size_t thread_count = threads > 1 ? (size_t)threads : 1;
+    thread_count = min(thread_count, max<size_t>(1, orders.size() / MIN_ORDERS_PER_THREAD));
+
+    // Словарь может расти только при чтении, а не во время расчётов
+    MetricSetup setup;
+    setup.sku_total = sku_count();
+    setup.approx_capacity = approx_capacity;
+
+    vector<Pipeline> parts(thread_count);
+    for (Pipeline& part : parts) {
+        part.init(setup);
+    }
+
+    if (thread_count == 1) {
+        parts[0].add_range(orders, 0, orders.size());
+    }
+    else {
+        // Каждый поток считает свой непрерывный диапазон заказов
+        size_t chunk = (orders.size() + thread_count - 1) / thread_count;
+        vector<thread> workers;
+        for (size_t t = 0; t < thread_count; t++) {
+            size_t begin = min(orders.size(), t * chunk);
+            size_t end = min(orders.size(), begin + chunk);
+            workers.emplace_back([&parts, &orders, t, begin, end]() {
+                parts[t].add_range(orders, begin, end);
+            });
+        }
+        for (thread& w : workers) {
+            w.join();
+        }
+
+        // Попарное дерево: на шаге stride часть i поглощает часть i + stride.
+        // Пары одного шага независимы и сливаются параллельно
+        for (size_t stride = 1; stride < thread_count; stride *= 2) {
+            vector<thread> mergers;
+            for (size_t i = 0; i + stride < thread_count; i += stride * 2) {
+                mergers.emplace_back([&parts, i, stride]() {
+                    parts[i].merge(parts[i + stride]);
+                    parts[i + stride] = Pipeline();
+                });
+            }
+            for (thread& m : mergers) {
+                m.join();
+            }
+        }
+    }
+
+    AnalyticsPart result;
+    parts[0].export_to(result);
+    return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "analytics.h"
+#include "validation.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// ========== ЧАСТИЧНЫЕ ИТОГИ ДЛЯ РАСЧЁТА НА НЕСКОЛЬКИХ УЗЛАХ ==========
+//
+// Каждый узел считает свою долю файлов (--shard i/N) и записывает итоги
+// в компактный двоичный файл (--emit-partial): итоги, выручку по дням и по
+// артикулам (артикул - текстом, номера на узлах разные), гистограмму,
+// скетчи квантилей и HyperLogLog, счётчики приблизительного топа и итог
+// проверки данных. --merge складывает такие файлы и печатает тот же отчёт,
+// что дал бы запуск на одном узле. Файл:
+//   PARTIAL_MAGIC, затем поля подряд числами переменной длины
+//   (знаковые - zigzag), строки - длина и байты.
+
+const char PARTIAL_MAGIC[8] = {'S', 'A', 'L', 'E', 'S', 'P', '1', '\0'};
+const uint32_t PARTIAL_VERSION = 1;
+
+// Что известно о части, кроме метрик
+struct PartialInfo {
+    int shard_index = 1;            // Номер доли (1..shard_count)
+    int shard_count = 1;
+    long long file_count = 0;       // Файлов в доле
+    unsigned metrics = 0;           // Какие метрики посчитаны
+    string date_from;               // Период --from/--to, с которым считали
+    string date_to;
+    long long orders_checked = 0;   // Заказов проверено
+    long long error_counts[ERR_CODE_COUNT] = {};   // Ошибки по типам
+    long long error_total = 0;
+    long long duplicates_removed = 0;   // Удалено повторов (--dedup)
+};
+
+// Выбрать долю index из count (1..count): файл попадает в долю по хешу
+// имени, поэтому доли не зависят от порядка обхода и точки монтирования
+vector<string> select_shard(const vector<string>& files, int index, int count);
+
+// Записать часть. false - ошибка записи (сообщение уже выведено)
+bool write_partial(const string& path, const AnalyticsPart& part, const PartialInfo& info);
+
+// Прочитать часть. Артикулы заносятся в общий словарь
+bool read_partial(const string& path, AnalyticsPart& part, PartialInfo& info);
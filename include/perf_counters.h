@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// Аппаратные счётчики, которые снимаются для каждого этапа
+enum PerfEvent {
+    PERF_CYCLES = 0,        // Такты процессора
+    PERF_INSTRUCTIONS,      // Выполненные инструкции
+    PERF_CACHE_MISSES,      // Промахи кэша (LLC)
+    PERF_BRANCH_MISSES,     // Неверно предсказанные ветвления
+    PERF_EVENT_COUNT
+};
+
+// Открытые дескрипторы perf_event_open (-1, если счётчик недоступен)
+struct PerfCounters {
+    int fd[PERF_EVENT_COUNT];
+    int open_errno;         // errno первой неудачной попытки открытия
+};
+
+// Результат замера одного этапа
+struct PerfSample {
+    bool valid[PERF_EVENT_COUNT];
+    long long value[PERF_EVENT_COUNT];
+};
+
+// Открыть счётчики для текущего процесса. false - ни один счётчик недоступен
+bool perf_open(PerfCounters& counters);
+
+// Закрыть все дескрипторы
+void perf_close(PerfCounters& counters);
+
+// Есть ли хотя бы один рабочий счётчик
+bool perf_available(const PerfCounters& counters);
+
+// Сбросить и запустить счётчики
+void perf_start(PerfCounters& counters);
+
+// Остановить счётчики и прочитать значения (с поправкой на мультиплексирование)
+PerfSample perf_stop(PerfCounters& counters);
+
+// Вывести IPC и промахи на заказ для этапа
+void print_perf_sample(const string& phase, const PerfSample& sample, size_t orders);
+
+// Объяснить, почему счётчики недоступны
+void print_perf_unavailable(const PerfCounters& counters);
@@ -0,0 +1,33 @@
+#pragma once
+#include "load_pipeline.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ========== СЕРВЕР ЗАПРОСОВ НА UNIX-СОКЕТЕ ==========
+//
+// Данные загружаются и считаются один раз, потом сервер слушает
+// локальный сокет. Запрос - одна строка, на соединении можно задать
+// сколько угодно запросов:
+//   report [text|json|csv]  - отчёт как у обычного запуска (summary, daily, top)
+//   summary                 - общая статистика
+//   daily [С [ПО]]          - выручка по дням
+//   top [N]                 - топ N товаров
+//   sku АРТИКУЛ             - выручка артикула
+//   ping
+// Ответ: "OK <длина>\n" и ровно <длина> байт текста, или "ERR <причина>\n".
+// Соединения обслуживает пул из workers потоков. Данные не меняются,
+// поэтому готовые ответы кэшируются и повторный запрос отдаётся из кэша.
+// Остановка - SIGINT или SIGTERM.
+
+// Сколько разных ответов держать в кэше
+const size_t SERVER_CACHE_LIMIT = 4096;
+
+// Самая длинная строка запроса: на более длинную отвечаем ERR и закрываем
+// соединение, чтобы клиент без перевода строки не занял всю память
+const size_t SERVER_MAX_LINE = 4096;
+
+// Запустить сервер на socket_path (старый файл сокета удаляется)
+int run_server(const string& socket_path, const vector<string>& inputs, const LoadOptions& options,
+               int workers, int top_count);
@@ -0,0 +1,88 @@
+#pragma once
+#include "sales_types.h"
+#include "analytics.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+
+using namespace std;
+
+// Отчёты, которые можно выбрать через --report
+enum ReportMask : unsigned {
+    REPORT_SUMMARY   = 1u << 0, // Общая статистика
+    REPORT_DAILY     = 1u << 1, // Выручка по дням
+    REPORT_TOP       = 1u << 2, // Топ товаров
+    REPORT_HISTOGRAM = 1u << 3, // Распределение сумм заказов
+    REPORTS_DEFAULT  = REPORT_SUMMARY | REPORT_DAILY | REPORT_TOP,
+    REPORTS_ALL      = REPORTS_DEFAULT | REPORT_HISTOGRAM
+};
+
+// Формат вывода отчёта (--output-format)
+enum OutputFormat {
+    OUTPUT_TEXT = 0,    // Таблицы для человека (как раньше)
+    OUTPUT_JSON,        // Один JSON-объект
+    OUTPUT_CSV          // Строки section,key,value
+};
+
+// Готовые результаты для отчёта
+struct ReportData {
+    unsigned sections = REPORTS_DEFAULT;    // Какие разделы выводить
+    long long order_count = 0;
+    long long item_count = 0;
+    Money total_revenue = 0;
+    Money average_check = 0;
+    vector<pair<int, Money>> check_percentiles;  // процентиль -> сумма чека (пусто - не считались)
+    bool has_distinct = false;              // Есть ли оценки числа разных значений
+    long long distinct_orders = 0;          // Оценки HyperLogLog
+    long long distinct_skus = 0;
+    map<string, long long> daily_distinct_skus; // дата -> разных артикулов за день
+    string date_from;                       // Период --from/--to (пусто - без границы)
+    string date_to;
+    map<string, Money> daily_revenue;       // дата -> выручка
+    vector<pair<string, Money>> top_products;   // артикул -> выручка, по убыванию
+    vector<Money> top_errors;               // Погрешность каждой строки топа (только --approx)
+    size_t approx_capacity = 0;             // Счётчиков приблизительного топа (0 - топ точный)
+    vector<long long> order_value_histogram;    // корзина -> число заказов
+};
+
+// Вывод через один большой буфер: текст копится в памяти и уходит
+// в файл блоками по REPORT_BUFFER_SIZE, без сброса на каждой строке.
+// Без файла (file == nullptr) весь текст остаётся в buffer
+struct ReportWriter {
+    FILE* file = nullptr;
+    bool owns_file = false;
+    string buffer;
+};
+
+const size_t REPORT_BUFFER_SIZE = 1 << 20;
+
+// Открыть вывод в файл (пустой путь - стандартный вывод)
+bool report_open(ReportWriter& writer, const string& path);
+
+// Добавить текст в буфер
+void report_append(ReportWriter& writer, const string& text);
+
+// Записать буфер в файл
+void report_flush(ReportWriter& writer);
+
+// Сбросить буфер и закрыть файл
+void report_close(ReportWriter& writer);
+
+// Разобрать имя формата: text, json, csv
+bool parse_output_format(const string& name, OutputFormat& format);
+
+// Сумма из копеек: "1234.56"
+string format_money(Money amount);
+
+// Линия из '=' длиной length
+string format_line(int length);
+
+// Заголовок раздела (пустая строка, линия, текст, линия, пустая строка)
+string format_header(const string& text);
+
+// Собрать данные отчёта из посчитанных метрик (топ - из top_count артикулов)
+ReportData make_report_data(const AnalyticsPart& stats, unsigned sections, int top_count);
+
+// Записать все выбранные разделы отчёта в нужном формате
+void write_report(ReportWriter& writer, const ReportData& data, OutputFormat format);
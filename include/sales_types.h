@@ -0,0 +1,44 @@
+#pragma once
+#include "sku_dictionary.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Денежная сумма в копейках. Целые суммы не зависят от порядка сложения,
+// поэтому результат одинаков при любом числе потоков
+typedef long long Money;
+
+// Меньше этого числа заказов на поток запускать потоки невыгодно
+// (общий порог для проверки, расчёта метрик и таблиц сброса)
+const size_t MIN_ORDERS_PER_THREAD = 10000;
+
+// Товар в заказе
+struct Item {
+    SkuId sku = EMPTY_SKU;  // Артикул товара (номер в словаре артикулов)
+    int quantity = 0;       // Количество
+    Money price = 0;        // Цена за штуку (в копейках)
+    uint32_t sku_offset = 0;    // Артикул без словаря: смещение в Order::sku_text + 1 (0 - нет)
+};
+
+// Есть ли у товара артикул (в словаре или текстом в заказе)
+inline bool item_has_sku(const Item& item) {
+    return item.sku != EMPTY_SKU || item.sku_offset != 0;
+}
+
+// Один заказ (продажа)
+struct Order {
+    string id;              // Номер заказа
+    string date_time;       // Дата и время
+    vector<Item> items;     // Список товаров
+    // Артикулы товаров текстом, через '\0', если они не заносились в словарь
+    // (ParseOptions::intern_skus); на них указывает Item::sku_offset
+    string sku_text;
+};
+
+// Текст артикула товара заказа (из словаря или из Order::sku_text)
+inline string_view item_sku(const Order& order, const Item& item) {
+    if (item.sku_offset != 0) return string_view(order.sku_text.c_str() + item.sku_offset - 1);
+    return sku_name(item.sku);
+}
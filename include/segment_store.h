@@ -0,0 +1,95 @@
+#pragma once
+#include "sales_types.h"
+#include "json_schema.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ========== СЕГМЕНТЫ: МНОГО МАЛЕНЬКИХ ФАЙЛОВ В НЕСКОЛЬКИХ БОЛЬШИХ ==========
+//
+// Директория "один заказ - один файл" читается медленно из-за открытия
+// и поиска каждого файла. --compact переписывает её в несколько сегментов
+// по ~SEGMENT_DEFAULT_SIZE байт. Сегмент:
+//   заголовок (SegmentHeader): число файлов, место каталога,
+//            самая ранняя и самая поздняя метка времени в сегменте,
+//            число файлов с заказами без даты
+//   тексты исходных файлов подряд, байт в байт (сжатые - распакованными)
+//   каталог: для каждого файла - имя (общее начало с предыдущим именем
+//            не повторяется), длина текста, число заказов, есть ли
+//            заказы без даты, первый и последний день (номера дней,
+//            разностями); тексты идут подряд, поэтому смещения не хранятся
+// Сегмент читается одним последовательным чтением. При --from/--to
+// сегмент вне периода пропускается по заголовку, не читаясь, а внутри
+// сегмента разбираются только файлы, чей период пересекается с нужным.
+// Заказ без ts парсер не отбрасывает по периоду (его отклоняет проверка
+// данных), поэтому файлы и сегменты с такими заказами читаются всегда.
+
+const char SEGMENT_MAGIC[8] = {'O', 'R', 'D', 'S', 'E', 'G', '1', '\0'};
+const uint32_t SEGMENT_VERSION = 2;
+const char SEGMENT_EXTENSION[] = ".oseg";
+const size_t SEGMENT_DEFAULT_SIZE = 64u << 20;
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t file_count;
+    uint64_t index_offset;      // Каталог (от начала файла)
+    uint64_t index_size;
+    char min_ts[24];            // Метки времени с нулём в конце (пусто - заказов нет)
+    char max_ts[24];
+    uint32_t undated_files;     // Файлов с заказами без даты (с версии 2)
+    uint32_t reserved;
+};
+
+// Заголовок версии 1 - без undated_files и reserved. Такие сегменты
+// читаются, но о заказах без даты в них ничего не известно
+const size_t SEGMENT_V1_HEADER_SIZE = offsetof(SegmentHeader, undated_files);
+
+// Один исходный файл внутри сегмента
+struct SegmentEntry {
+    string name;                // Путь относительно сжимаемой директории
+    uint64_t offset = 0;        // Текст файла (от начала сегмента)
+    uint64_t length = 0;
+    uint32_t order_count = 0;
+    bool dated = false;         // Есть ли заказы с датой
+    bool undated = false;       // Есть ли заказы без даты
+    int min_day = 0;            // Дни от 1970-01-01 (day_number)
+    int max_day = 0;
+};
+
+struct CompactOptions {
+    string output_dir;                      // Куда писать сегменты
+    size_t segment_size = SEGMENT_DEFAULT_SIZE;
+    bool remove_originals = false;          // Проверить сегменты и удалить исходные файлы
+    int threads = 1;                        // Потоков обхода директории
+};
+
+struct CompactStats {
+    size_t files = 0;
+    size_t segments = 0;
+    long long orders = 0;
+    uint64_t bytes_in = 0;      // Исходных файлов (как на диске)
+    uint64_t bytes_out = 0;     // Сегментов
+    size_t removed = 0;         // Удалено исходных файлов
+};
+
+// Имя сегмента (по расширению)
+bool is_segment_file(const string& filename);
+
+// Начинается ли содержимое с подписи сегмента
+bool is_segment(const string& data);
+
+// Переписать все файлы с заказами из dir (рекурсивно) в сегменты.
+// false - ошибка (сообщение уже выведено)
+bool compact_directory(const string& dir, const CompactOptions& options, CompactStats& stats);
+
+// Заказы сегмента в порядке исходных файлов; файлы вне периода
+// options.date_from/date_to не разбираются
+vector<Order> read_segment(const string& data, const ParseOptions& options);
+
+// Может ли в сегменте быть заказ за период options (читается только заголовок).
+// Не сегмент или без периода - true
+bool segment_may_match(const string& path, const ParseOptions& options);
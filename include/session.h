@@ -0,0 +1,50 @@
+#pragma once
+#include "load_pipeline.h"
+#include <string>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+// ========== ИНТЕРАКТИВНАЯ СЕССИЯ ==========
+//
+// Данные загружаются один раз и остаются в памяти вместе с посчитанными
+// метриками, дальше команды отвечают из готовых таблиц:
+//   top [N]            - топ товаров по выручке
+//   daily [С [ПО]]     - выручка по дням (даты YYYY-MM-DD)
+//   sku АРТИКУЛ        - выручка и место артикула
+//   stats              - общая статистика
+//   reload [ПУТЬ ...]  - перечитать данные (те же или новые пути)
+//   help, exit
+// При выходе печатается отчёт по сессии.
+
+// Данные, которые держит сессия
+struct SessionData {
+    vector<string> inputs;
+    vector<Order> orders;
+    AnalyticsPart stats;        // Все метрики по orders
+    size_t file_count = 0;
+};
+
+// Что происходило за сессию (для отчёта при выходе)
+struct SessionLog {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int commands = 0;
+    size_t files = 0;
+    long long orders = 0;
+    Money revenue = 0;
+    vector<pair<string, long long>> loads;     // пути загрузки -> заказов
+};
+
+// Загрузить данные (все поля и все метрики). При ошибке прежние данные остаются
+bool session_load(SessionData& data, const vector<string>& inputs, const LoadOptions& options, SessionLog& log);
+
+// Ответы на команды (готовый текст)
+string answer_stats(const SessionData& data);
+string answer_top(const SessionData& data, int top_count);
+// Выручка по дням за период [from, to] (пустая граница - без ограничения)
+string answer_daily(const SessionData& data, const string& from, const string& to);
+string answer_sku(const SessionData& data, const string& sku);
+
+// Запустить сессию: inputs - пути как у --input, команды читаются из stdin
+int run_session(const vector<string>& inputs, const LoadOptions& options, int top_count);
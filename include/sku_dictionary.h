@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Номер артикула в общем словаре
+typedef uint32_t SkuId;
+
+// Номер пустого артикула (занят заранее)
+const SkuId EMPTY_SKU = 0;
+
+// Найти артикул в словаре или добавить новый. Строка хранится один раз,
+// в товарах лежит только 32-битный номер. Безопасно вызывать из разных потоков
+SkuId intern_sku(string_view sku);
+
+// Номер артикула без добавления в словарь (EMPTY_SKU, если такого нет)
+SkuId find_sku(string_view sku);
+
+// Текст артикула по номеру
+const string& sku_name(SkuId id);
+
+// Сколько артикулов в словаре (номера 0 .. sku_count() - 1)
+size_t sku_count();
@@ -0,0 +1,61 @@
+#pragma once
+#include "sales_types.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// ========== ИНДЕКС ПО АРТИКУЛАМ НА ДИСКЕ ==========
+//
+// Для каждого артикула - список записей (день, количество, выручка),
+// по одной записи на день. Записи сжаты: разность дней и суммы пишутся
+// числами переменной длины (7 бит на байт). Файл:
+//   заголовок (SkuIndexHeader)
+//   списки записей артикулов подряд
+//   каталог: артикул -> смещение и размер его списка (по алфавиту),
+//            блоками по SKU_INDEX_BLOCK артикулов
+//   верхний уровень: первый артикул каждого блока -> границы блока
+// Запрос читает заголовок, верхний уровень, один блок каталога и список
+// одного артикула, а не все заказы и не весь каталог.
+
+const char SKU_INDEX_MAGIC[8] = {'S', 'K', 'U', 'I', 'D', 'X', '1', '\0'};
+const uint32_t SKU_INDEX_VERSION = 1;
+const size_t SKU_INDEX_BLOCK = 128;
+
+struct SkuIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sku_count;
+    uint64_t directory_offset;
+    uint64_t directory_size;
+    uint64_t blocks_offset;
+    uint64_t blocks_size;
+};
+
+// Одна запись: продажи артикула за день
+struct SkuPosting {
+    int day = 0;                // Дней с 1970-01-01
+    long long quantity = 0;
+    Money revenue = 0;
+};
+
+// Номер дня по дате YYYY-MM-DD (по первым 10 символам строки)
+int day_number(const string& date);
+
+// Дата YYYY-MM-DD по номеру дня
+string day_date(int day);
+
+// Сколько записано (для сообщения после построения)
+struct SkuIndexStats {
+    size_t sku_count = 0;
+    size_t posting_count = 0;
+    size_t file_size = 0;
+};
+
+// Построить индекс по заказам и записать в path. false - ошибка записи
+bool write_sku_index(const string& path, const vector<Order>& orders, SkuIndexStats& stats);
+
+// Прочитать записи одного артикула (по возрастанию дня).
+// found = false, если артикула нет в индексе. false - файл не читается
+bool read_sku_postings(const string& path, const string& sku, vector<SkuPosting>& postings, bool& found);
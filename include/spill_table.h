@@ -0,0 +1,73 @@
+#pragma once
+#include "sales_types.h"
+#include "analytics.h"
+#include <cstdio>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ========== ВЫРУЧКА ПО АРТИКУЛАМ В ОГРАНИЧЕННОЙ ПАМЯТИ (--memory-limit) ==========
+//
+// Обычно выручка по артикулам копится в массивах размером со словарь
+// артикулов, по копии на каждый поток. С --memory-limit вместо них
+// хеш-таблица, разбитая по хешу артикула на SPILL_PARTITIONS частей.
+// Когда записей больше, чем помещается в бюджет, самая большая часть
+// дописывается во временный файл (записями SpillRecord) и очищается.
+// В конце части собираются по одной: записи из файла и остаток в памяти
+// складываются, и артикулы части предлагаются в кучу из top_count лучших,
+// а для частичных итогов (top_count = 0) дописываются разреженными
+// записями SkuTotal - плотного массива по всем артикулам не бывает. Суммы целые,
+// поэтому топ совпадает с расчётом целиком в памяти.
+// Словарь артикулов (текст каждого артикула) при этом остаётся в памяти
+// целиком: лимит ограничивает суммы по артикулам, а не словарь.
+
+const int SPILL_PARTITIONS = 64;
+
+// Оценка памяти на одну запись unordered_map: узел с ключом, суммами
+// и указателем, служебные байты malloc и доля корзин
+const size_t SPILL_ENTRY_BYTES = 56;
+
+// Меньше стольких записей таблица не сбрасывается: иначе при крошечном
+// лимите на диск уходила бы почти каждая позиция
+const size_t SPILL_MIN_ENTRIES = 4096;
+
+// Суммы одного артикула
+struct SpillTotals {
+    Money revenue = 0;
+    uint32_t lines = 0;
+};
+
+// Запись во временном файле (16 байт)
+typedef SkuTotal SpillRecord;
+
+// Таблица одного потока
+struct SpillTable {
+    size_t max_entries = 0;         // Сколько записей помещается в бюджет
+    int top_count = 0;              // Сколько лучших артикулов оставить (0 - все, записями SkuTotal)
+    size_t entries = 0;             // Записей в памяти сейчас
+    unordered_map<SkuId, SpillTotals> partitions[SPILL_PARTITIONS];
+    FILE* files[SPILL_PARTITIONS] = {};     // Временные файлы частей (nullptr - часть не сбрасывалась)
+    long long spill_count = 0;      // Сколько раз часть уходила на диск
+    long long spilled_bytes = 0;
+
+    SpillTable(size_t memory_limit, int top_count);
+    ~SpillTable();
+    SpillTable(const SpillTable&) = delete;
+    SpillTable& operator=(const SpillTable&) = delete;
+
+    void add(SkuId sku, Money revenue);
+};
+
+// Учесть позиции заказов [begin, end)
+void spill_add_orders(SpillTable& table, const vector<Order>& orders, size_t begin, size_t end);
+
+// Собрать таблицы (по одной на поток) в product_top результата (top_count
+// лучших артикулов) или, при top_count = 0, в product_totals; таблицы после
+// этого пусты
+void spill_finish(const vector<SpillTable*>& tables, AnalyticsPart& result);
+
+// Выручка по артикулам заказов в бюджете memory_limit байт на все потоки
+void spill_aggregate(const vector<Order>& orders, int threads, size_t memory_limit, int top_count,
+                     AnalyticsPart& result);
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+using namespace std;
+
+// Сколько файлов одновременно находится в обработке io_uring
+const size_t URING_QUEUE_DEPTH = 256;
+
+// Доступен ли io_uring с нужными операциями (openat, read, close)
+bool uring_available();
+
+// Прочитать файлы пачками через io_uring (системные вызовы напрямую, без liburing).
+// В очереди одновременно до queue_depth файлов: открытие, чтение и закрытие
+// отправляются в ядро пачками, одним io_uring_enter на пачку.
+// on_file(index, contents) вызывается строго по порядку путей; если файл
+// не открылся, contents пустое и выводится предупреждение.
+// Возвращает false, если io_uring недоступен (тогда ничего не прочитано).
+// delivered - сколько первых файлов отдано on_file. Если io_uring сломался
+// посреди работы, результат true, но delivered < paths.size(): остальные
+// файлы нужно дочитать обычным чтением, начиная с номера delivered
+bool uring_read_files(const vector<string>& paths, size_t queue_depth,
+                      const function<void(size_t index, string& contents)>& on_file, size_t& delivered);
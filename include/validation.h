@@ -0,0 +1,57 @@
+#pragma once
+#include "sales_types.h"
+#include "json_schema.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Типы ошибок в данных
+enum ValidationErrorCode : uint8_t {
+    ERR_EMPTY_ID = 0,       // Пустой ID заказа
+    ERR_BAD_DATE,           // Неправильная дата
+    ERR_NO_ITEMS,           // В заказе нет товаров
+    ERR_EMPTY_SKU,          // Пустой артикул
+    ERR_BAD_QUANTITY,       // Количество <= 0
+    ERR_NEGATIVE_PRICE,     // Отрицательная цена
+    ERR_CODE_COUNT
+};
+
+// Одна найденная ошибка (без строк, 12 байт)
+struct ValidationError {
+    uint32_t order_index;   // Номер заказа в векторе
+    int32_t item_index;     // Номер товара или -1 для ошибок заказа
+    ValidationErrorCode code;
+};
+
+// Параметры проверки
+struct ValidationOptions {
+    size_t max_errors = 0;      // Остановиться после N ошибок (0 - без ограничения)
+    size_t sample_size = 20;    // Сколько ошибок сохранить для вывода
+    int threads = 1;            // Сколько потоков проверяют заказы
+    unsigned fields = FIELDS_ALL;   // Какие поля были прочитаны (остальные не проверяются)
+};
+
+// Итог проверки
+struct ValidationResult {
+    long long counts[ERR_CODE_COUNT];   // Количество ошибок по типам
+    long long total;                    // Всего ошибок
+    vector<ValidationError> sample;     // Первые ошибки по порядку заказов
+    bool stopped_early;                 // Сработал лимит --max-errors
+};
+
+// Проверить все заказы (при threads > 1 - параллельно по диапазонам)
+ValidationResult validate_orders(const vector<Order>& orders, const ValidationOptions& options);
+
+// Текстовое описание типа ошибки
+const char* validation_error_name(ValidationErrorCode code);
+
+// Вывести итог проверки одним буфером
+void print_validation_result(const vector<Order>& orders, const ValidationResult& result);
+
+// То же, когда заказы не хранились (проверка по ходу загрузки):
+// orders - только заказы из образца ошибок, по их сквозным номерам
+void print_validation_result(const map<size_t, Order>& orders, const ValidationResult& result);
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// ========== ЧИСЛА ПЕРЕМЕННОЙ ДЛИНЫ ДЛЯ ДВОИЧНЫХ ФАЙЛОВ ==========
+
+// Число переменной длины: по 7 бит в байте, старший бит - "дальше ещё байт"
+inline void put_varint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+inline bool get_varint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// Знаковые числа: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ... (малые по модулю - короткие)
+inline uint64_t zigzag(long long value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline long long unzigzag(uint64_t value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
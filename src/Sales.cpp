@@ -1,4 +1,20 @@
 #include "../include/generate_data_mf.h"
+#include "../include/perf_counters.h"
+#include "../include/sales_types.h"
+#include "../include/validation.h"
+#include "../include/analytics.h"
+#include "../include/json_parser.h"
+#include "../include/report_writer.h"
+#include "../include/uring_reader.h"
+#include "../include/load_pipeline.h"
+#include "../include/input_files.h"
+#include "../include/sku_index.h"
+#include "../include/session.h"
+#include "../include/query_server.h"
+#include "../include/dedup.h"
+#include "../include/partial_aggregate.h"
+#include "../include/gzip_reader.h"
+#include "../include/segment_store.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -10,209 +26,14 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cctype>
+#include <cstring>
+#include <cerrno>
 #include <stdexcept>
+#include <thread>
+#include <climits>
 
 using namespace std;
 
-// Товар в заказе
-struct Item {
-    string sku;        // Артикул товара
-    int quantity;      // Количество
-    double price;      // Цена за штуку
-};
-
-// Один заказ (продажа)
-struct Order {
-    string id;              // Номер заказа
-    string date_time;       // Дата и время
-    vector<Item> items;     // Список товаров
-};
-
-// Убрать пробелы в начале строки
-void skip_spaces(const string& text, int& position) {
-    while (position < text.length() && (text[position] == ' ' ||
-                                        text[position] == '\n' || text[position] == '\t' || text[position] == '\r')) {
-        position++;
-    }
-}
-
-// Прочитать строку из JSON (в кавычках)
-string read_json_string(const string& text, int& position) {
-    skip_spaces(text, position);
-
-    // Пропускаем открывающую кавычку
-    if (text[position] != '"') {
-        cout << "Ошибка: ожидалась кавычка на позиции " << position << endl;
-        return "";
-    }
-    position++;
-
-    // Читаем символы до закрывающей кавычки
-    string result = "";
-    while (position < text.length() && text[position] != '"') {
-        if (text[position] == '\\') {  // Обработка спецсимволов
-            position++;
-            if (text[position] == 'n') result += '\n';
-            else if (text[position] == 't') result += '\t';
-            else result += text[position];
-        }
-        else {
-            result += text[position];
-        }
-        position++;
-    }
-
-    // Пропускаем закрывающую кавычку
-    position++;
-    return result;
-}
-
-// Прочитать число из JSON
-double read_json_number(const string& text, int& position) {
-    skip_spaces(text, position);
-
-    string number_string = "";
-
-    // Минус для отрицательных чисел
-    if (text[position] == '-') {
-        number_string += text[position];
-        position++;
-    }
-
-    // Читаем цифры
-    while (position < text.length() && (isdigit(text[position]) || text[position] == '.')) {
-        number_string += text[position];
-        position++;
-    }
-
-    // Преобразуем строку в число
-    return stod(number_string);
-}
-
-// Прочитать один товар из JSON
-Item read_json_item(const string& text, int& position) {
-    Item item;
-
-    skip_spaces(text, position);
-    position++; // Пропускаем {
-
-    // Читаем поля товара
-    while (text[position] != '}') {
-        skip_spaces(text, position);
-
-        if (text[position] == ',') {
-            position++;
-            continue;
-        }
-
-        if (text[position] == '}') break;
-
-        // Читаем имя поля
-        string field_name = read_json_string(text, position);
-
-        skip_spaces(text, position);
-        position++; // Пропускаем :
-
-        // Читаем значение поля
-        if (field_name == "sku") {
-            item.sku = read_json_string(text, position);
-        }
-        else if (field_name == "qty") {
-            item.quantity = (int)read_json_number(text, position);
-        }
-        else if (field_name == "price") {
-            item.price = read_json_number(text, position);
-        }
-    }
-
-    position++; // Пропускаем }
-    return item;
-}
-
-// Прочитать один заказ из JSON
-Order read_json_order(const string& text, int& position) {
-    Order order;
-
-    skip_spaces(text, position);
-    position++; // Пропускаем {
-
-    // Читаем поля заказа
-    while (text[position] != '}') {
-        skip_spaces(text, position);
-
-        if (text[position] == ',') {
-            position++;
-            continue;
-        }
-
-        if (text[position] == '}') break;
-
-        // Читаем имя поля
-        string field_name = read_json_string(text, position);
-
-        skip_spaces(text, position);
-        position++; // Пропускаем :
-
-        // Читаем значение поля
-        if (field_name == "id") {
-            order.id = read_json_string(text, position);
-        }
-        else if (field_name == "ts") {
-            order.date_time = read_json_string(text, position);
-        }
-        else if (field_name == "items") {
-            skip_spaces(text, position);
-            position++; // Пропускаем [
-
-            // Читаем все товары
-            while (text[position] != ']') {
-                skip_spaces(text, position);
-
-                if (text[position] == ',') {
-                    position++;
-                    continue;
-                }
-
-                if (text[position] == ']') break;
-
-                Item item = read_json_item(text, position);
-                order.items.push_back(item);
-            }
-
-            position++; // Пропускаем ]
-        }
-    }
-
-    position++; // Пропускаем }
-    return order;
-}
-
-// Прочитать все заказы из JSON
-vector<Order> read_json(const string& text) {
-    vector<Order> orders;
-    int position = 0;
-
-    skip_spaces(text, position);
-    position++; // Пропускаем [
-
-    // Читаем все заказы
-    while (position < text.length() && text[position] != ']') {
-        skip_spaces(text, position);
-
-        if (text[position] == ',') {
-            position++;
-            continue;
-        }
-
-        if (text[position] == ']') break;
-
-        Order order = read_json_order(text, position);
-        orders.push_back(order);
-    }
-
-    return orders;
-}
-
 // ========== НОВЫЕ ФУНКЦИИ ДЛЯ РАБОТЫ С ДИРЕКТОРИЯМИ ==========
 
 // Проверить, является ли путь директорией
@@ -294,31 +115,27 @@ void show_available_directories(const string& base_path) {
 
 
 // Прочитать один файл с заказами
-vector<Order> read_single_file(const string& filepath) {
-    ifstream file(filepath);
-    if (!file.is_open()) {
-        cerr << "Предупреждение: не могу открыть файл " << filepath << endl;
+vector<Order> read_single_file(const string& filepath, const ParseOptions& options = ParseOptions()) {
+    // Файл .json.gz распаковывается по ходу чтения
+    string json_text;
+    if (!read_text_file(filepath, json_text)) {
+        cerr << "Предупреждение: не могу прочитать файл " << filepath << endl;
         return vector<Order>();
     }
 
-    string json_text = "";
-    string line;
-    while (getline(file, line)) {
-        json_text += line;
-    }
-    file.close();
-
-    return read_json(json_text);
+    if (is_segment(json_text)) return read_segment(json_text, options);
+    return read_json(json_text, options);
 }
 
-// Прочитать все JSON файлы из директории
-vector<Order> read_directory(const string& dir_path, bool show_progress = true) {
-    vector<Order> all_orders;
+// Пути ко всем JSON файлам директории, по порядку имён.
+// Если таких файлов нет, показывает поддиректории
+vector<string> list_json_files(const string& dir_path) {
+    vector<string> filepaths;
 
     DIR* dir = opendir(dir_path.c_str());
     if (dir == nullptr) {
         cerr << "Ошибка: не могу открыть директорию " << dir_path << endl;
-        return all_orders;
+        return filepaths;
     }
 
     // Собираем имена всех JSON файлов
@@ -331,7 +148,7 @@ vector<Order> read_directory(const string& dir_path, bool show_progress = true)
         if (filename == "." || filename == "..") continue;
 
         // Берём только .json файлы
-        if (filename.find(".json") == string::npos) continue;
+        if (!is_orders_file(filename)) continue;
 
         filenames.push_back(filename);
     }
@@ -345,26 +162,40 @@ vector<Order> read_directory(const string& dir_path, bool show_progress = true)
         cout << endl;
         cout << "В директории " << dir_path << " нет JSON файлов." << endl;
         show_available_directories(dir_path);
+        return filepaths;
+    }
+
+    for (const string& filename : filenames) {
+        filepaths.push_back(dir_path + "/" + filename);
+    }
+    return filepaths;
+}
+
+// Прочитать все JSON файлы из директории по одному (чтение и разбор по очереди)
+// use_uring - читать файлы пачками через io_uring (если ядро его не даёт,
+// используется обычное чтение по одному файлу)
+vector<Order> read_directory(const string& dir_path, bool show_progress = true,
+                             const ParseOptions& options = ParseOptions(), bool use_uring = true) {
+    vector<Order> all_orders;
+
+    vector<string> filepaths = list_json_files(dir_path);
+    if (filepaths.empty()) {
         return all_orders;
     }
 
-    int total = filenames.size();
+    int total = filepaths.size();
     int processed = 0;
 
     if (show_progress) {
         cout << "Найдено JSON файлов: " << total << endl;
     }
 
-    // Читаем каждый файл
-    for (const string& filename : filenames) {
-        string filepath = dir_path + "/" + filename;
-
-        vector<Order> orders = read_single_file(filepath);
-
-        // Добавляем все заказы из файла
-        for (const Order& order : orders) {
-            if (!order.id.empty()) {
-                all_orders.push_back(order);
+    // Добавить заказы из файла (без ID - только если ID читался)
+    bool need_id = (options.fields & FIELD_ID) != 0;
+    auto add_orders = [&](vector<Order>& orders) {
+        for (Order& order : orders) {
+            if (!need_id || !order.id.empty()) {
+                all_orders.push_back(move(order));
             }
         }
 
@@ -375,6 +206,33 @@ vector<Order> read_directory(const string& dir_path, bool show_progress = true)
             cout << "  Прочитано файлов: " << processed << "/" << total
                  << " (" << (processed * 100 / total) << "%)" << endl;
         }
+    };
+
+    // Пачками через io_uring: файлы приходят по порядку, сразу в парсер
+    size_t delivered = 0;
+    if (use_uring) {
+        bool started = uring_read_files(filepaths, URING_QUEUE_DEPTH, [&](size_t index, string& contents) {
+            if (is_gzip(contents)) {
+                // Повреждённый архив пропускаем, как и конвейер загрузки
+                string unpacked;
+                if (!gunzip(contents, unpacked)) {
+                    cerr << "Предупреждение: повреждён сжатый файл " << filepaths[index] << ", пропущен" << endl;
+                    unpacked.clear();
+                }
+                contents = move(unpacked);
+            }
+            vector<Order> orders = is_segment(contents) ? read_segment(contents, options) : read_json(contents, options);
+            add_orders(orders);
+        }, delivered);
+        if (!started && show_progress) {
+            cout << "  io_uring недоступен, обычное чтение файлов" << endl;
+        }
+    }
+
+    // Читаем каждый файл (после сбоя io_uring - начиная с первого непрочитанного)
+    for (size_t k = delivered; k < filepaths.size(); k++) {
+        vector<Order> orders = read_single_file(filepaths[k], options);
+        add_orders(orders);
     }
 
     return all_orders;
@@ -383,186 +241,226 @@ vector<Order> read_directory(const string& dir_path, bool show_progress = true)
 // ========== КОНЕЦ НОВЫХ ФУНКЦИЙ ==========
 
 // Проверить все заказы на правильность
-bool check_orders(const vector<Order>& orders) {
-    bool all_ok = true;
-    int error_count = 0;
-
-    // Проверяем каждый заказ
-    for (int i = 0; i < orders.size(); i++) {
-        const Order& order = orders[i];
+bool check_orders(const vector<Order>& orders, const ValidationOptions& options = ValidationOptions()) {
+    ValidationResult result = validate_orders(orders, options);
+    print_validation_result(orders, result);
+    return result.total == 0;
+}
 
-        // Проверка: ID не пустой
-        if (order.id.empty()) {
-            cout << "  Ошибка в заказе #" << i << ": пустой ID" << endl;
-            all_ok = false;
-            error_count++;
-        }
+// Дата в виде YYYY-MM-DD (для --from и --to)
+bool is_valid_date(const string& date) {
+    if (date.length() != 10 || date[4] != '-' || date[7] != '-') return false;
+    for (int k : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (!isdigit((unsigned char)date[k])) return false;
+    }
+    return true;
+}
 
-        // Проверка: дата правильного формата
-        if (order.date_time.length() < 10) {
-            cout << "  Ошибка в заказе #" << i << " (ID: " << order.id
-                 << "): неправильная дата" << endl;
-            all_ok = false;
-            error_count++;
+// Разобрать список отчётов "daily,top,summary". 0 - ошибка в списке
+unsigned parse_report_list(const string& list) {
+    unsigned reports = 0;
+    size_t start = 0;
+    while (start <= list.length()) {
+        size_t comma = list.find(',', start);
+        if (comma == string::npos) comma = list.length();
+        string name = list.substr(start, comma - start);
+
+        if (name == "summary") reports |= REPORT_SUMMARY;
+        else if (name == "daily") reports |= REPORT_DAILY;
+        else if (name == "top") reports |= REPORT_TOP;
+        else if (name == "hist") reports |= REPORT_HISTOGRAM;
+        else if (name == "all") reports |= REPORTS_ALL;
+        else {
+            cerr << "Ошибка: неизвестный отчёт " << name << endl;
+            return 0;
         }
+        start = comma + 1;
+    }
+    return reports;
+}
 
-        // Проверка: есть хотя бы один товар
-        if (order.items.empty()) {
-            cout << "  Ошибка в заказе #" << i << " (ID: " << order.id
-                 << "): нет товаров" << endl;
-            all_ok = false;
-            error_count++;
-        }
+// Какие поля JSON нужны выбранным отчётам: для выручки всегда qty и price,
+// дата - для выручки по дням, артикул - для топа; общей статистике нужны
+// ID, дата и артикул (число разных заказов и артикулов, в том числе по дням).
+// Проверка данных и отбор заказов без ID охватывают только прочитанные поля
+unsigned fields_for_reports(unsigned reports) {
+    unsigned fields = FIELD_QTY | FIELD_PRICE;
+    if (reports & REPORT_SUMMARY) fields |= FIELD_ID | FIELD_TS | FIELD_SKU;
+    if (reports & REPORT_DAILY) fields |= FIELD_TS;
+    if (reports & REPORT_TOP) fields |= FIELD_SKU;
+    return fields;
+}
 
-        // Проверяем каждый товар в заказе
-        for (int j = 0; j < order.items.size(); j++) {
-            const Item& item = order.items[j];
+// Какие метрики считать для выбранных отчётов (итоги считаются всегда).
+// approx - топ товаров приблизительно, в ограниченной памяти
+unsigned metrics_for_reports(unsigned reports, bool approx = false) {
+    unsigned metrics = 0;
+    if (reports & REPORT_SUMMARY) metrics |= METRIC_QUANTILES | METRIC_DISTINCT;
+    if (reports & REPORT_DAILY) metrics |= METRIC_DAILY;
+    if (reports & REPORT_TOP) metrics |= approx ? METRIC_APPROX_SKU : METRIC_SKU;
+    if (reports & REPORT_HISTOGRAM) metrics |= METRIC_HISTOGRAM;
+    return metrics;
+}
 
-            // Проверка: артикул не пустой
-            if (item.sku.empty()) {
-                cout << "  Ошибка в заказе #" << i << ", товар #" << j
-                     << ": пустой артикул" << endl;
-                all_ok = false;
-                error_count++;
-            }
+// Вывести линию
+void print_line(int length) {
+    cout << format_line(length);
+}
 
-            // Проверка: количество больше 0
-            if (item.quantity <= 0) {
-                cout << "  Ошибка в заказе #" << i << ", товар #" << j
-                     << " (" << item.sku << "): количество должно быть > 0" << endl;
-                all_ok = false;
-                error_count++;
-            }
+// Вывести заголовок
+void print_header(const string& text) {
+    cout << format_header(text);
+}
 
-            // Проверка: цена >= 0
-            if (item.price < 0) {
-                cout << "  Ошибка в заказе #" << i << ", товар #" << j
-                     << " (" << item.sku << "): цена не может быть отрицательной" << endl;
-                all_ok = false;
-                error_count++;
-            }
-        }
-    }
+// Ответить на запрос по одному артикулу из индекса (--query-sku).
+// Период - из options (--from/--to), daily - печатать выручку по дням
+int run_sku_query(const string& index_path, const string& sku, const ParseOptions& options, bool daily) {
+    auto time_start = chrono::high_resolution_clock::now();
 
-    if (all_ok) {
-        cout << "\nВсе данные правильные!" << endl;
+    vector<SkuPosting> postings;
+    bool found = false;
+    if (!read_sku_postings(index_path, sku, postings, found)) {
+        return 1;
     }
-    else {
-        cout << "\nНайдено ошибок: " << error_count << endl;
+    if (!found) {
+        cout << "Артикул " << sku << " не найден в индексе" << endl;
+        return 1;
     }
 
-    return all_ok;
-}
+    int from = options.date_from.empty() ? INT_MIN : day_number(options.date_from);
+    int to = options.date_to.empty() ? INT_MAX : day_number(options.date_to);
 
-// Посчитать стоимость одного заказа
-double calculate_order_total(const Order& order) {
-    double total = 0;
-    for (int i = 0; i < order.items.size(); i++) {
-        total += order.items[i].quantity * order.items[i].price;
+    string text = format_header("АРТИКУЛ " + sku);
+    if (daily) {
+        text += "Дата            Кол-во      Выручка\n";
+        text += "--------------------------------------------\n";
     }
-    return total;
-}
 
-// Получить дату из строки (YYYY-MM-DD)
-string get_date(const string& date_time) {
-    if (date_time.length() >= 10) {
-        return date_time.substr(0, 10);  // Берем первые 10 символов
+    long long quantity = 0;
+    Money revenue = 0;
+    int days = 0;
+    for (const SkuPosting& posting : postings) {
+        if (posting.day < from || posting.day > to) continue;
+        quantity += posting.quantity;
+        revenue += posting.revenue;
+        days++;
+        if (daily) {
+            string count = to_string(posting.quantity);
+            text += day_date(posting.day) + "      " + count + string(count.size() < 12 ? 12 - count.size() : 1, ' ') +
+                    format_money(posting.revenue) + " руб.\n";
+        }
     }
-    return date_time;
-}
-
-// Посчитать выручку по дням
-map<string, double> calculate_daily_revenue(const vector<Order>& orders) {
-    map<string, double> daily_revenue;  // дата -> выручка
-    map<string, int> daily_count;       // дата -> количество заказов
+    if (daily) text += "\n";
 
-    // Суммируем выручку по каждому дню
-    for (int i = 0; i < orders.size(); i++) {
-        string date = get_date(orders[i].date_time);
-        double order_total = calculate_order_total(orders[i]);
-
-        daily_revenue[date] += order_total;
-        daily_count[date]++;
+    if (!options.date_from.empty() || !options.date_to.empty()) {
+        text += "Период:               " + (options.date_from.empty() ? string("...") : options.date_from) +
+                " - " + (options.date_to.empty() ? string("...") : options.date_to) + "\n";
     }
+    text += "Дней с продажами:     " + to_string(days) + "\n";
+    text += "Продано штук:         " + to_string(quantity) + "\n";
+    text += "Выручка:              " + format_money(revenue) + " руб.\n";
 
-    return daily_revenue;
+    auto time_end = chrono::high_resolution_clock::now();
+    text += "\nЗапрос занял " +
+            to_string(chrono::duration_cast<chrono::microseconds>(time_end - time_start).count()) + " мкс\n";
+    cout << text;
+    return 0;
 }
 
-// Посчитать средний чек
-double calculate_average_check(const vector<Order>& orders) {
-    if (orders.empty()) return 0;
-
-    double total = 0;
-    for (int i = 0; i < orders.size(); i++) {
-        total += calculate_order_total(orders[i]);
+// Сложить частичные итоги (--merge) и вывести отчёт, как у запуска на одном узле
+int run_merge(const vector<string>& paths, unsigned reports, int top_count, OutputFormat format,
+              const string& output_path) {
+    // JSON/CSV в консоль: служебные сообщения уходят в stderr
+    if (format != OUTPUT_TEXT && output_path.empty()) {
+        cout.rdbuf(cerr.rdbuf());
     }
 
-    return total / orders.size();
-}
+    cout << "Сложение частичных итогов: " << paths.size() << " файлов" << endl;
 
-// Сортировка пар в products
-bool f(pair<string, double>& a, pair<string, double>& b) {
-    return a.second > b.second;
-}
+    AnalyticsPart total;
+    PartialInfo first;
+    long long files = 0;
+    long long error_counts[ERR_CODE_COUNT] = {};
+    long long error_total = 0;
+    long long duplicates_removed = 0;
+    vector<int> shard_seen;
 
-// Найти топ товаров по выручке
-vector<pair<string, double>> find_top_products(const vector<Order>& orders, int top_count) {
-    map<string, double> product_revenue;  // артикул -> выручка
+    for (size_t k = 0; k < paths.size(); k++) {
+        AnalyticsPart part;
+        PartialInfo info;
+        if (!read_partial(paths[k], part, info)) {
+            return 1;
+        }
+        cout << "  " << paths[k] << ": доля " << info.shard_index << "/" << info.shard_count << ", файлов "
+             << info.file_count << ", заказов " << info.orders_checked << endl;
+
+        if (k == 0) {
+            first = info;
+            shard_seen.assign(info.shard_count + 1, 0);
+        }
+        else if (info.shard_count != first.shard_count || info.date_from != first.date_from ||
+                 info.date_to != first.date_to || info.metrics != first.metrics) {
+            cout << "Предупреждение: " << paths[k] << " посчитан с другими параметрами (доли, период или метрики)"
+                 << endl;
+        }
+        if (info.shard_index < (int)shard_seen.size()) shard_seen[info.shard_index]++;
 
-    // Суммируем выручку по каждому товару
-    for (int i = 0; i < orders.size(); i++) {
-        for (int j = 0; j < orders[i].items.size(); j++) {
-            const Item& item = orders[i].items[j];
-            product_revenue[item.sku] += item.quantity * item.price;
+        files += info.file_count;
+        duplicates_removed += info.duplicates_removed;
+        error_total += info.error_total;
+        for (int e = 0; e < ERR_CODE_COUNT; e++) {
+            error_counts[e] += info.error_counts[e];
         }
+        merge_analytics(total, part);
     }
 
-    // Переносим в вектор для сортировки
-    vector<pair<string, double>> products;
-    for (map<string, double>::iterator it = product_revenue.begin();
-         it != product_revenue.end(); ++it) {
-        products.push_back(make_pair(it->first, it->second));
+    // Доли должны покрывать все файлы ровно один раз
+    for (size_t s = 1; s < shard_seen.size(); s++) {
+        if (shard_seen[s] == 0) {
+            cout << "Предупреждение: нет доли " << s << "/" << first.shard_count << endl;
+        } else if (shard_seen[s] > 1) {
+            cout << "Предупреждение: доля " << s << "/" << first.shard_count << " учтена " << shard_seen[s]
+                 << " раза" << endl;
+        }
+    }
+    cout << "Всего файлов: " << files << ", заказов: " << total.order_count << endl;
+    if (duplicates_removed > 0) {
+        // Каждая доля искала повторы только в своих файлах
+        cout << "Удалено повторных заказов (--dedup): " << duplicates_removed
+             << " (повторы между долями не ищутся)" << endl;
     }
 
-    // Сортируем по выручке (от большего к меньшему)
-    /*for (int i = 0; i < products.size(); i++) {
-        for (int j = i + 1; j < products.size(); j++) {
-            if (products[j].second > products[i].second) {
-                swap(products[i], products[j]);
+    if (error_total > 0) {
+        for (int e = 0; e < ERR_CODE_COUNT; e++) {
+            if (error_counts[e] > 0) {
+                cout << "  " << validation_error_name((ValidationErrorCode)e) << ": " << error_counts[e] << endl;
             }
         }
-    }*/
-    sort(products.begin(), products.end(), f);
+        cout << "Найдено ошибок: " << error_total << endl;
+        cout << "\nОшибка: в данных есть ошибки, анализ остановлен" << endl;
+        return 1;
+    }
 
-    // Оставляем только топ N
-    if (products.size() > top_count) {
-        products.resize(top_count);
+    unsigned needed = metrics_for_reports(reports, total.approx_capacity > 0);
+    if ((needed & ~first.metrics) != 0) {
+        cout << "Предупреждение: в частичных итогах нет данных для части отчётов" << endl;
     }
 
-    return products;
-}
+    ReportData report = make_report_data(total, reports, top_count);
+    report.date_from = first.date_from;
+    report.date_to = first.date_to;
 
-// Вывести линию
-void print_line(int length) {
-    for (int i = 0; i < length; i++) {
-        cout << "=";
+    ReportWriter writer;
+    if (!report_open(writer, output_path)) {
+        return 1;
     }
-    cout << endl;
-}
-
-// Вывести заголовок
-void print_header(const string& text) {
-    cout << endl;
-    print_line(70);
-    cout << "  " << text << endl;
-    print_line(70);
-    cout << endl;
-}
+    write_report(writer, report, format);
+    report_close(writer);
 
-// Вывести сумму денег
-void print_money(double amount) {
-    cout.precision(2);
-    cout << fixed << amount << " руб.";
+    if (!output_path.empty()) {
+        cout << "Отчёт записан в " << output_path << endl;
+    }
+    return 0;
 }
 
 // ========== НАЧАЛО ФУНКЦИЙ БЫСТРОГО ТЕСТА ==========
@@ -622,22 +520,72 @@ map<int, long long> benchmark_generation(const string& base_dir) {
     return results;
 }
 
+// Время расчётов одного набора: в один поток и в threads потоков
+struct AnalyticsTiming {
+    long long serial_us;
+    long long parallel_us;
+    bool same_result;
+};
+
 // Benchmark обработки
-map<int, long long> benchmark_processing(const string& base_dir) {
+// Если counters открыты, для каждого размера снимаются счётчики по этапам
+// (загрузка, проверка, расчёты) в perf_results.
+// Расчёты дополнительно повторяются в один поток, чтобы оценить ускорение
+map<int, long long> benchmark_processing(const string& base_dir, int threads, PerfCounters* counters,
+                                         map<int, vector<PerfSample>>& perf_results,
+                                         map<int, AnalyticsTiming>& analytics_timing) {
     vector<int> sizes = {10, 100, 1000, 10000, 100000, 250000};
     map<int, long long> results;
 
     for (int n : sizes) {
         string dir = base_dir + "/gen_" + to_string(n);
+        vector<PerfSample> samples;
 
         auto start = chrono::high_resolution_clock::now();
+
+        if (counters) perf_start(*counters);
         vector<Order> orders = read_directory(dir, false);
-        check_orders(orders);
-        calculate_average_check(orders);
-        find_top_products(orders, 5);
+        if (counters) samples.push_back(perf_stop(*counters));
+
+        ValidationOptions validation_options;
+        validation_options.threads = threads;
+
+        if (counters) perf_start(*counters);
+        check_orders(orders, validation_options);
+        if (counters) samples.push_back(perf_stop(*counters));
+
+        if (counters) perf_start(*counters);
+        auto parallel_start = chrono::high_resolution_clock::now();
+        AnalyticsPart parallel = aggregate_orders(orders, threads, METRIC_SKU);
+        vector<pair<string, Money>> parallel_top = top_products_from(parallel, 5);
+        auto parallel_end = chrono::high_resolution_clock::now();
+        if (counters) samples.push_back(perf_stop(*counters));
+
         auto end = chrono::high_resolution_clock::now();
 
         results[n] = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+        // Тот же расчёт в один поток: для ускорения и сверки результатов
+        auto serial_start = chrono::high_resolution_clock::now();
+        AnalyticsPart serial = aggregate_orders(orders, 1, METRIC_SKU);
+        vector<pair<string, Money>> serial_top = top_products_from(serial, 5);
+        auto serial_end = chrono::high_resolution_clock::now();
+
+        AnalyticsTiming timing;
+        timing.serial_us = chrono::duration_cast<chrono::microseconds>(serial_end - serial_start).count();
+        timing.parallel_us = chrono::duration_cast<chrono::microseconds>(parallel_end - parallel_start).count();
+        timing.same_result = serial.total_revenue == parallel.total_revenue &&
+                             serial.daily_revenue == parallel.daily_revenue &&
+                             serial_top == parallel_top;
+        analytics_timing[n] = timing;
+
+        if (counters) {
+            cout << "Набор gen_" << n << " (" << orders.size() << " заказов):" << endl;
+            print_perf_sample("Загрузка", samples[0], orders.size());
+            print_perf_sample("Проверка", samples[1], orders.size());
+            print_perf_sample("Расчёты", samples[2], orders.size());
+            perf_results[n] = samples;
+        }
     }
     return results;
 }
@@ -646,7 +594,10 @@ map<int, long long> benchmark_processing(const string& base_dir) {
 void write_benchmark_report(
         int test_id,
         const map<int, long long>& gen,
-        const map<int, long long>& proc
+        const map<int, long long>& proc,
+        const map<int, vector<PerfSample>>& perf,
+        int threads,
+        const map<int, AnalyticsTiming>& analytics
 ) {
     string filename = "tests/t" + to_string(test_id) + ".md";
     ofstream f(filename);
@@ -666,17 +617,70 @@ void write_benchmark_report(
     f << "|--------------|-------------|\n";
     for (auto& p : proc)
         f << "| " << p.first << " | " << p.second << " |\n";
+
+    f << "\n\n2.1) Расчёты: 1 поток против " << threads << " потоков.\n\n";
+    f << "| Кол-во файлов | 1 поток (us) | " << threads << " потоков (us) | Ускорение | Результаты совпали |\n";
+    f << "|--------------|--------------|---------------|-----------|--------------------|\n";
+    f.precision(2);
+    f << fixed;
+    for (auto& p : analytics) {
+        double speedup = p.second.parallel_us > 0 ? (double)p.second.serial_us / p.second.parallel_us : 0;
+        f << "| " << p.first << " | " << p.second.serial_us << " | " << p.second.parallel_us
+          << " | " << speedup << "x | " << (p.second.same_result ? "да" : "НЕТ") << " |\n";
+    }
+
+    if (perf.empty()) return;
+
+    // IPC по этапам: загрузка / проверка / расчёты
+    f << "\n\n3) Аппаратные счётчики обработки (IPC, промахи кэша на заказ).\n\n";
+    f << "| Кол-во файлов | IPC загрузки | IPC проверки | IPC расчётов | Промахи кэша/заказ |\n";
+    f << "|--------------|--------------|--------------|--------------|--------------------|\n";
+    for (auto& p : perf) {
+        f << "| " << p.first;
+        long long misses = 0;
+        bool misses_valid = false;
+        for (const PerfSample& s : p.second) {
+            if (s.valid[PERF_CYCLES] && s.valid[PERF_INSTRUCTIONS] && s.value[PERF_CYCLES] > 0) {
+                f << " | " << (double)s.value[PERF_INSTRUCTIONS] / s.value[PERF_CYCLES];
+            } else {
+                f << " | -";
+            }
+            if (s.valid[PERF_CACHE_MISSES]) {
+                misses += s.value[PERF_CACHE_MISSES];
+                misses_valid = true;
+            }
+        }
+        if (misses_valid) {
+            f << " | " << (double)misses / p.first << " |\n";
+        } else {
+            f << " | - |\n";
+        }
+    }
 }
 
 // быстрый тест
-void run_benchmark_tests() {
+void run_benchmark_tests(int threads, bool use_perf_counters) {
     int test_id = get_next_test_index();
     string dir = create_test_directory(test_id);
 
+    PerfCounters counters;
+    PerfCounters* counters_ptr = nullptr;
+    if (use_perf_counters) {
+        if (perf_open(counters)) {
+            counters_ptr = &counters;
+        } else {
+            print_perf_unavailable(counters);
+        }
+    }
+
     auto gen_results = benchmark_generation(dir);
-    auto proc_results = benchmark_processing(dir);
+    map<int, vector<PerfSample>> perf_results;
+    map<int, AnalyticsTiming> analytics_timing;
+    auto proc_results = benchmark_processing(dir, threads, counters_ptr, perf_results, analytics_timing);
+
+    if (use_perf_counters) perf_close(counters);
 
-    write_benchmark_report(test_id, gen_results, proc_results);
+    write_benchmark_report(test_id, gen_results, proc_results, perf_results, threads, analytics_timing);
 
     cout << "Benchmark завершён: tests/t" << test_id << endl;
 }
@@ -685,6 +689,30 @@ void run_benchmark_tests() {
 int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "RU");
     bool start_test = false;
+    bool use_perf_counters = false;
+    int thread_count = max(1u, thread::hardware_concurrency());
+    unsigned reports = REPORTS_DEFAULT;
+    ParseOptions parse_options;
+    OutputFormat output_format = OUTPUT_TEXT;
+    bool use_uring = true;
+    size_t load_buffers = LOAD_DEFAULT_BUFFERS;
+    size_t memory_limit = 0;        // --memory-limit, байт (0 - без лимита)
+    string index_path = "";
+    string build_index_path = "";
+    string query_sku = "";
+    bool query_daily = false;
+    bool interactive = false;
+    string socket_path = "";
+    size_t approx_capacity = 0;     // 0 - точный топ
+    DedupOptions dedup_options;
+    int shard_index = 1;            // --shard i/N
+    int shard_count = 1;
+    string partial_path = "";
+    vector<string> merge_paths;
+    string compact_dir = "";
+    CompactOptions compact_options;
+    string output_path = "";
+    ValidationOptions validation_options;
 
 
     // ===== РЕЖИМ ГЕНЕРАЦИИ =====
@@ -696,7 +724,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Переменные для параметров
-    string input_path = "";
+    vector<string> input_paths;
     int top_count = 5;
 
     // Читаем параметры командной строки
@@ -715,7 +743,44 @@ int main(int argc, char* argv[]) {
             cout << "Опции:" << endl;
             cout << "  -h, --help       Показать справку" << endl;
             cout << "  -i, --input      Файл или директория с данными" << endl;
+            cout << "                   Можно несколько путей и шаблонов (--input a/ b/*.json),\n"
+                 << "                   директории читаются со всеми поддиректориями" << endl;
             cout << "  -t, --top        Сколько товаров показать (по умолчанию 5)" << endl;
+            cout << "  --perf-counters  Аппаратные счётчики (IPC, промахи) по этапам" << endl;
+            cout << "  --max-errors N   Остановить проверку после N ошибок" << endl;
+            cout << "  --threads N      Число потоков (по умолчанию - все ядра)" << endl;
+            cout << "  --report СПИСОК  Какие отчёты строить: summary,daily,top,hist,all\n"
+                 << "                   (по умолчанию summary,daily,top). Читаются только поля\n"
+                 << "                   этих отчётов, и проверяются только они: без summary не\n"
+                 << "                   проверяются ID (и не отбрасываются заказы без ID), без\n"
+                 << "                   summary и daily - даты, без summary и top - артикулы" << endl;
+            cout << "  --output-format  Формат отчёта: text, json или csv (по умолчанию text)" << endl;
+            cout << "  --out ФАЙЛ       Записать отчёт в файл вместо консоли" << endl;
+            cout << "  --reader ТИП     Чтение директории: uring (по умолчанию) или posix" << endl;
+            cout << "  --from ДАТА      Только заказы с этой даты (YYYY-MM-DD)" << endl;
+            cout << "  --to ДАТА        Только заказы по эту дату включительно" << endl;
+            cout << "  --interactive    Загрузить данные один раз и отвечать на команды\n"
+                 << "                   (top, daily, sku, stats, reload)" << endl;
+            cout << "  --approx [N]     Приблизительный топ в N счётчиках (по умолчанию 1024)\n"
+                 << "                   с погрешностью у каждого товара" << endl;
+            cout << "  --dedup РЕЖИМ    Повторные заказы (один номер в разных файлах):\n"
+                 << "                   report - сообщить, drop - оставить первый, last - последний" << endl;
+            cout << "  --dedup-bloom    Меньше памяти на --dedup: сначала фильтр Блума" << endl;
+            cout << "  --compact ДИР    Переписать файлы директории в большие сегменты .oseg\n"
+                 << "                   (в ДИР_segments или --compact-to ДИР2, размер --segment-size МБ,\n"
+                 << "                   по умолчанию 64; --remove-originals - сверить и удалить исходные)" << endl;
+            cout << "  --memory-limit МБ\n"
+                 << "                   Выручка по артикулам в пределах МБ памяти (лишнее - во временные\n"
+                 << "                   файлы в $TMPDIR), заказы директории не хранятся целиком.\n"
+                 << "                   Словарь артикулов (их тексты) в лимит не входит и хранится целиком" << endl;
+            cout << "  --shard i/N      Считать только долю i из N файлов (для нескольких узлов)" << endl;
+            cout << "  --emit-partial Ф Записать частичные итоги в двоичный файл Ф" << endl;
+            cout << "  --merge Ф...     Сложить частичные итоги и вывести общий отчёт" << endl;
+            cout << "  --serve СОКЕТ    Загрузить данные и отвечать на запросы через Unix-сокет" << endl;
+            cout << "  --build-index Ф  Построить индекс по артикулам и записать в файл Ф" << endl;
+            cout << "  --query-sku АРТ  Выручка артикула из индекса (нужен --index Ф,\n"
+                 << "                   учитывает --from/--to, --daily - по дням)" << endl;
+            cout << "  --buffers N      Сколько файлов директории в работе одновременно (по умолчанию 64)" << endl;
             cout << endl;
             cout << "Примеры:" << endl;
             cout << "  ./sales --input data/sales_100.json" << endl;
@@ -729,9 +794,204 @@ int main(int argc, char* argv[]) {
             start_test = true;
         }
 
-        if (arg == "--input" || arg == "-i") {
+        if (arg == "--perf-counters") {
+            use_perf_counters = true;
+        }
+
+        if (arg == "--max-errors") {
             if (i + 1 < argc) {
-                input_path = argv[i + 1];
+                validation_options.max_errors = stoul(argv[i + 1]);
+                i++;
+            }
+        }
+
+        if (arg == "--threads") {
+            if (i + 1 < argc) {
+                thread_count = max(1, stoi(argv[i + 1]));
+                i++;
+            }
+        }
+
+        if (arg == "--report") {
+            if (i + 1 < argc) {
+                reports = parse_report_list(argv[i + 1]);
+                if (reports == 0) return 1;
+                parse_options.fields = fields_for_reports(reports);
+                i++;
+            }
+        }
+
+        if (arg == "--output-format") {
+            if (i + 1 < argc) {
+                if (!parse_output_format(argv[i + 1], output_format)) {
+                    cerr << "Ошибка: неизвестный формат " << argv[i + 1] << " (text, json, csv)" << endl;
+                    return 1;
+                }
+                i++;
+            }
+        }
+
+        if (arg == "--out") {
+            if (i + 1 < argc) {
+                output_path = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--reader") {
+            if (i + 1 < argc) {
+                string reader = argv[i + 1];
+                if (reader != "uring" && reader != "posix") {
+                    cerr << "Ошибка: неизвестный способ чтения " << reader << " (uring, posix)" << endl;
+                    return 1;
+                }
+                use_uring = reader == "uring";
+                i++;
+            }
+        }
+
+        if (arg == "--from" || arg == "--to") {
+            if (i + 1 < argc) {
+                string date = argv[i + 1];
+                if (!is_valid_date(date)) {
+                    cerr << "Ошибка: дата " << date << " не в формате YYYY-MM-DD" << endl;
+                    return 1;
+                }
+                (arg == "--from" ? parse_options.date_from : parse_options.date_to) = date;
+                i++;
+            }
+        }
+
+        if (arg == "--interactive") {
+            interactive = true;
+        }
+
+        if (arg == "--approx") {
+            approx_capacity = APPROX_TOP_DEFAULT_CAPACITY;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                approx_capacity = max(1, stoi(argv[i + 1]));
+                i++;
+            }
+        }
+
+        if (arg == "--shard") {
+            if (i + 1 < argc) {
+                string shard = argv[i + 1];
+                size_t slash = shard.find('/');
+                if (slash == string::npos || sscanf(shard.c_str(), "%d/%d", &shard_index, &shard_count) != 2 ||
+                    shard_count < 1 || shard_index < 1 || shard_index > shard_count) {
+                    cerr << "Ошибка: доля задаётся как i/N, 1 <= i <= N (например, 2/4)" << endl;
+                    return 1;
+                }
+                i++;
+            }
+        }
+
+        if (arg == "--emit-partial") {
+            if (i + 1 < argc) {
+                partial_path = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--merge") {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                merge_paths.push_back(argv[i + 1]);
+                i++;
+            }
+        }
+
+        if (arg == "--compact") {
+            if (i + 1 < argc) {
+                compact_dir = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--compact-to") {
+            if (i + 1 < argc) {
+                compact_options.output_dir = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--segment-size") {
+            if (i + 1 < argc) {
+                compact_options.segment_size = (size_t)max(1, stoi(argv[i + 1])) << 20;
+                i++;
+            }
+        }
+
+        if (arg == "--remove-originals") {
+            compact_options.remove_originals = true;
+        }
+
+        if (arg == "--dedup") {
+            if (i + 1 < argc) {
+                string mode = argv[i + 1];
+                if (!parse_dedup_mode(mode, dedup_options.mode)) {
+                    cerr << "Ошибка: неизвестный режим проверки повторов " << mode << " (report, drop, last)" << endl;
+                    return 1;
+                }
+                i++;
+            }
+        }
+
+        if (arg == "--dedup-bloom") {
+            dedup_options.bloom = true;
+            if (dedup_options.mode == DEDUP_OFF) dedup_options.mode = DEDUP_REPORT;
+        }
+
+        if (arg == "--serve") {
+            if (i + 1 < argc) {
+                socket_path = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--build-index") {
+            if (i + 1 < argc) {
+                build_index_path = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--index") {
+            if (i + 1 < argc) {
+                index_path = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--query-sku") {
+            if (i + 1 < argc) {
+                query_sku = argv[i + 1];
+                i++;
+            }
+        }
+
+        if (arg == "--daily") {
+            query_daily = true;
+        }
+
+        if (arg == "--memory-limit") {
+            if (i + 1 < argc) {
+                memory_limit = (size_t)max(1, stoi(argv[i + 1])) << 20;
+                i++;
+            }
+        }
+
+        if (arg == "--buffers") {
+            if (i + 1 < argc) {
+                load_buffers = max(1, stoi(argv[i + 1]));
+                i++;
+            }
+        }
+
+        // После --input можно перечислить несколько путей и шаблонов
+        if (arg == "--input" || arg == "-i") {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                input_paths.push_back(argv[i + 1]);
                 i++;
             }
         }
@@ -744,140 +1004,352 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // Период проверяется по дате заказа, поэтому ts читается всегда
+    if (!parse_options.date_from.empty() || !parse_options.date_to.empty()) {
+        parse_options.fields |= FIELD_TS;
+    }
+
+    // Повторы ищутся по номеру заказа
+    if (dedup_options.mode != DEDUP_OFF) {
+        parse_options.fields |= FIELD_ID;
+    }
+
+    // Частичным итогам нужны все метрики, какие бы отчёты ни выбрали при сложении
+    if (!partial_path.empty()) {
+        parse_options.fields |= FIELDS_ALL;
+    }
+
+    // Индексу нужны дата и все поля товаров
+    if (!build_index_path.empty()) {
+        parse_options.fields |= FIELD_TS | FIELDS_ITEM;
+    }
+
+    validation_options.threads = thread_count;
+    validation_options.fields = parse_options.fields;
+
     if (start_test) {
-        run_benchmark_tests();
+        run_benchmark_tests(thread_count, use_perf_counters);
         return 0;
     }
 
+    // Запрос к готовому индексу: данные не читаются
+    if (!query_sku.empty()) {
+        if (index_path.empty()) {
+            cout << "Ошибка: для --query-sku нужен --index <файл>" << endl;
+            return 1;
+        }
+        return run_sku_query(index_path, query_sku, parse_options, query_daily);
+    }
+
+    // Сжатие директории в сегменты: анализ не запускается
+    if (!compact_dir.empty()) {
+        while (compact_dir.size() > 1 && compact_dir.back() == '/') compact_dir.pop_back();
+        if (compact_options.output_dir.empty()) compact_options.output_dir = compact_dir + "_segments";
+        compact_options.threads = thread_count;
+
+        auto compact_start = chrono::high_resolution_clock::now();
+        CompactStats compact_stats;
+        bool compacted = compact_directory(compact_dir, compact_options, compact_stats);
+        auto compact_end = chrono::high_resolution_clock::now();
+        if (compact_stats.files == 0) return 1;
+
+        cout << "Файлов: " << compact_stats.files << ", заказов: " << compact_stats.orders << ", сегментов: "
+             << compact_stats.segments << " (" << compact_stats.bytes_in / 1024 << " КБ -> "
+             << compact_stats.bytes_out / 1024 << " КБ) за "
+             << chrono::duration_cast<chrono::milliseconds>(compact_end - compact_start).count() << " мс" << endl;
+        if (compact_options.remove_originals) {
+            cout << "Удалено исходных файлов: " << compact_stats.removed << endl;
+        }
+        return compacted ? 0 : 1;
+    }
+
+    // Сложение частичных итогов с нескольких узлов: данные не читаются
+    if (!merge_paths.empty()) {
+        return run_merge(merge_paths, reports, top_count, output_format, output_path);
+    }
+
 
     // Проверяем, что указан файл или директория
-    if (input_path.empty()) {
+    if (input_paths.empty()) {
         cout << "Ошибка: не указан файл или директория с данными" << endl;
         cout << "Используйте: ./sales --input <файл_или_директория>" << endl;
         return 1;
     }
 
+    // Интерактивная сессия и сервер: данные остаются в памяти между запросами
+    if (interactive || !socket_path.empty()) {
+        LoadOptions load_options;
+        load_options.parse = parse_options;
+        load_options.parser_threads = thread_count;
+        load_options.buffers = load_buffers;
+        load_options.use_uring = use_uring;
+        load_options.dedup = dedup_options;
+        if (interactive) {
+            return run_session(input_paths, load_options, top_count);
+        }
+        return run_server(socket_path, input_paths, load_options, thread_count, top_count);
+    }
+
+    // JSON/CSV в консоль: служебные сообщения уходят в stderr,
+    // чтобы в stdout остался только машиночитаемый отчёт
+    if (output_format != OUTPUT_TEXT && output_path.empty()) {
+        cout.rdbuf(cerr.rdbuf());
+    }
+
     cout << endl;
     print_line(70);
     cout << "     АНАЛИЗ ПРОДАЖ" << endl;
     print_line(70);
     cout << endl;
 
+    // Аппаратные счётчики по этапам (если запрошены и доступны)
+    PerfCounters counters;
+    bool perf_enabled = false;
+    PerfSample load_perf, check_perf, calc_perf;
+    if (use_perf_counters) {
+        perf_enabled = perf_open(counters);
+        if (!perf_enabled) {
+            print_perf_unavailable(counters);
+            cout << endl;
+        }
+    }
+
+    string input_path = input_paths[0];
+    for (size_t k = 1; k < input_paths.size(); k++) {
+        input_path += ", " + input_paths[k];
+    }
+
+    // Один путь без шаблона, и это не директория - читаем как один файл
+    // (с --shard - как список из одного файла, чтобы он попал в свою долю)
+    bool single_file = input_paths.size() == 1 && !is_directory(input_paths[0]) &&
+                       input_paths[0].find_first_of("*?[") == string::npos && shard_count == 1;
+
+    // Приблизительный топ ведётся по тексту артикула: словарь артикулов
+    // не заполняется, и память не растёт с их числом. Индексу нужны номера
+    if (approx_capacity > 0 && build_index_path.empty()) {
+        parse_options.intern_skus = false;
+    }
+
     // ШАГ 1: Загружаем данные
     cout << "Шаг 1: Загрузка из " << input_path << "..." << endl;
 
+    if (perf_enabled) perf_start(counters);
     auto time_start = chrono::high_resolution_clock::now();
 
     vector<Order> orders;
 
-    // Определяем, это файл или директория
-    if (is_directory(input_path)) {
-        cout << "Режим: чтение директории" << endl;
-        orders = read_directory(input_path);
+    // Директории читаются конвейером, который заодно считает метрики
+    unsigned metrics = metrics_for_reports(reports, approx_capacity > 0);
+    if (!partial_path.empty()) {
+        metrics = approx_capacity > 0 ? (METRICS_ALL & ~METRIC_SKU) | METRIC_APPROX_SKU : METRICS_ALL;
+    }
+    PartialInfo partial;
+    partial.shard_index = shard_index;
+    partial.shard_count = shard_count;
+    partial.metrics = metrics;
+    partial.date_from = parse_options.date_from;
+    partial.date_to = parse_options.date_to;
+    LoadResult loaded;
+    bool pipelined = false;
+    DedupStats dedup_stats;
+
+    // С лимитом памяти конвейер не хранит заказы, а проверяет их сам.
+    // Заказы нужны целиком только индексу и повторам, которые не ищутся по ходу
+    bool stream_orders = memory_limit > 0 && build_index_path.empty() &&
+                         (dedup_options.mode == DEDUP_OFF || dedup_streams(dedup_options));
+    long long order_total = 0;
+
+    // С лимитом памяти выручка по артикулам сводится сразу к топу отчёта.
+    // Частичным итогам нужны все артикулы - для них топ не отбирается
+    int spill_top = partial_path.empty() ? max(top_count, 1) : 0;
+
+    // Определяем, это файл или директории
+    if (!single_file) {
+        if (input_paths.size() == 1 && is_directory(input_paths[0])) {
+            cout << "Режим: чтение директории" << endl;
+        } else {
+            cout << "Режим: чтение нескольких путей" << endl;
+        }
+
+        // Все файлы всех путей, директории - со всеми поддиректориями
+        vector<string> filepaths = collect_input_files(input_paths, thread_count);
+        if (shard_count > 1) {
+            size_t all = filepaths.size();
+            filepaths = select_shard(filepaths, shard_index, shard_count);
+            cout << "Доля " << shard_index << "/" << shard_count << ": " << filepaths.size() << " из " << all
+                 << " файлов" << endl;
+        }
+        partial.file_count = filepaths.size();
+
+        // Сегменты вне периода --from/--to не читаются (по заголовку)
+        if (!parse_options.date_from.empty() || !parse_options.date_to.empty()) {
+            size_t before = filepaths.size();
+            vector<string> kept;
+            for (const string& path : filepaths) {
+                if (segment_may_match(path, parse_options)) kept.push_back(path);
+            }
+            filepaths.swap(kept);
+            if (filepaths.size() < before) {
+                cout << "Пропущено сегментов вне периода: " << before - filepaths.size() << endl;
+            }
+        }
+        if (filepaths.empty() && input_paths.size() == 1 && is_directory(input_paths[0])) {
+            cout << endl;
+            cout << "В директории " << input_path << " нет JSON файлов." << endl;
+            show_available_directories(input_path);
+        }
+        if (!filepaths.empty()) {
+            cout << "Найдено JSON файлов: " << filepaths.size() << endl;
+
+            LoadOptions load_options;
+            load_options.parse = parse_options;
+            load_options.metrics = metrics;
+            load_options.parser_threads = thread_count;
+            load_options.buffers = load_buffers;
+            load_options.use_uring = use_uring;
+            if (approx_capacity > 0) load_options.approx_capacity = approx_capacity;
+            load_options.dedup = dedup_options;
+            load_options.memory_limit = memory_limit;
+            load_options.top_count = spill_top;
+            load_options.keep_orders = !stream_orders;
+            load_options.validation = validation_options;
+            loaded = load_files(filepaths, load_options);
+            orders = move(loaded.orders);
+            dedup_stats = loaded.dedup;
+            pipelined = true;
+        }
     } else {
         cout << "Режим: чтение одного файла" << endl;
 
-        ifstream file(input_path);
-        if (!file.is_open()) {
-            cout << "Ошибка: не могу открыть файл" << endl;
+        // Файл .json.gz распаковывается по ходу чтения
+        string json_text;
+        if (!read_text_file(input_path, json_text)) {
+            cout << "Ошибка: не могу открыть файл (или сжатый файл повреждён)" << endl;
             return 1;
         }
 
-        string json_text = "";
-        string line;
-        while (getline(file, line)) {
-            json_text += line;
-        }
-        file.close();
-
-        orders = read_json(json_text);
+        orders = is_segment(json_text) ? read_segment(json_text, parse_options) : read_json(json_text, parse_options);
+        partial.file_count = 1;
+        dedup_stats = deduplicate_orders(orders, dedup_options);
     }
 
     auto time_end = chrono::high_resolution_clock::now();
+    if (perf_enabled) load_perf = perf_stop(counters);
     int load_time = chrono::duration_cast<chrono::milliseconds>(time_end - time_start).count();
 
-    cout << "  Загружено заказов: " << orders.size() << " за " << load_time << " мс" << endl;
+    // Без хранения заказов считаем по итогам конвейера
+    bool streamed = pipelined && stream_orders;
+    order_total = streamed ? loaded.order_count : (long long)orders.size();
+
+    cout << "  Загружено заказов: " << order_total << " за " << load_time << " мс" << endl;
+    if (dedup_options.mode != DEDUP_OFF) {
+        print_dedup_stats(dedup_stats, dedup_options);
+    }
+
+    partial.duplicates_removed = dedup_stats.removed;
 
-    if (orders.empty()) {
-        cout << "Ошибка: не удалось загрузить данные" << endl;
+    // Пустая доля - тоже часть: без неё --merge не узнает, что доля посчитана
+    if (order_total == 0 && !partial_path.empty()) {
+        cout << "Нет заказов в доле, записываются пустые итоги" << endl;
+        return write_partial(partial_path, AnalyticsPart(), partial) ? 0 : 1;
+    }
+
+    if (order_total == 0) {
+        if (!parse_options.date_from.empty() || !parse_options.date_to.empty()) {
+            cout << "Нет заказов за указанный период" << endl;
+        } else {
+            cout << "Ошибка: не удалось загрузить данные" << endl;
+        }
         return 1;
     }
 
     // ШАГ 2: Проверяем данные
     cout << "\nШаг 2: Проверка данных..." << endl;
 
+    if (perf_enabled) perf_start(counters);
     time_start = chrono::high_resolution_clock::now();
 
-    bool data_ok = check_orders(orders);
+    // Без хранения заказов проверка уже прошла по ходу загрузки
+    ValidationResult validation = streamed ? loaded.validation : validate_orders(orders, validation_options);
+    if (streamed) {
+        print_validation_result(loaded.error_orders, validation);
+    } else {
+        print_validation_result(orders, validation);
+    }
+    bool data_ok = validation.total == 0;
 
     time_end = chrono::high_resolution_clock::now();
+    if (perf_enabled) check_perf = perf_stop(counters);
     int check_time = chrono::duration_cast<chrono::milliseconds>(time_end - time_start).count();
 
     cout << "  Проверка заняла " << check_time << " мс" << endl;
 
+    partial.orders_checked = order_total;
+    partial.error_total = validation.total;
+    for (int k = 0; k < ERR_CODE_COUNT; k++) {
+        partial.error_counts[k] = validation.counts[k];
+    }
+
     if (!data_ok) {
         cout << "\nОшибка: в данных есть ошибки, анализ остановлен" << endl;
+        // Часть всё равно записывается: --merge должен узнать об ошибках
+        if (!partial_path.empty()) write_partial(partial_path, AnalyticsPart(), partial);
         return 1;
     }
 
     // ШАГ 3: Делаем расчеты
     cout << "\nШаг 3: Анализ данных..." << endl;
 
+    if (perf_enabled) perf_start(counters);
     time_start = chrono::high_resolution_clock::now();
 
-    // Считаем общую статистику
-    double total_revenue = 0;
-    int total_items = 0;
-
-    for (int i = 0; i < orders.size(); i++) {
-        total_revenue += calculate_order_total(orders[i]);
-        total_items += orders[i].items.size();
+    // Нужные отчётам метрики за один проход (параллельно по диапазонам заказов).
+    // При чтении директории они уже посчитаны конвейером загрузки
+    AnalyticsPart stats = pipelined ? move(loaded.analytics) : aggregate_orders(orders, thread_count, metrics,
+                                                                     max(approx_capacity, (size_t)1), memory_limit,
+                                                                     spill_top);
+    if (memory_limit > 0) {
+        cout << "Лимит памяти " << (memory_limit >> 20) << " МБ: таблица артикулов сброшена на диск "
+             << stats.spill_count << " раз (" << stats.spilled_bytes / 1024 << " КБ)" << endl;
     }
 
-    double average_check = calculate_average_check(orders);
-
-    // Выводим общую статистику
-    print_header("ОБЩАЯ СТАТИСТИКА");
-
-    cout << "Всего заказов:        " << orders.size() << endl;
-    cout << "Общая выручка:        "; print_money(total_revenue); cout << endl;
-    cout << "Средний чек:          "; print_money(average_check); cout << endl;
-    cout << "Всего товаров:        " << total_items << endl;
-    cout << endl;
-
-    // Считаем выручку по дням
-    map<string, double> daily = calculate_daily_revenue(orders);
+    // Собираем результаты для отчёта
+    ReportData report = make_report_data(stats, reports, top_count);
+    report.date_from = parse_options.date_from;
+    report.date_to = parse_options.date_to;
 
-    print_header("ВЫРУЧКА ПО ДНЯМ");
-
-    cout << "Дата            Выручка" << endl;
-    cout << "--------------------------------" << endl;
-
-    for (map<string, double>::iterator it = daily.begin(); it != daily.end(); ++it) {
-        cout << it->first << "      ";
-        print_money(it->second);
-        cout << endl;
+    // Выводим отчёт одним буфером (в консоль или в файл --out)
+    ReportWriter writer;
+    if (!report_open(writer, output_path)) {
+        return 1;
     }
+    write_report(writer, report, output_format);
+    report_close(writer);
 
-    cout << endl;
-
-    // Находим топ товаров
-    vector<pair<string, double>> top_products = find_top_products(orders, top_count);
-
-    print_header("ТОП ТОВАРОВ ПО ВЫРУЧКЕ");
-
-    cout << "№   Артикул          Выручка" << endl;
-    cout << "------------------------------------" << endl;
+    if (!output_path.empty()) {
+        cout << "Отчёт записан в " << output_path << endl;
+    }
 
-    for (int i = 0; i < top_products.size(); i++) {
-        cout << (i + 1) << ".  " << top_products[i].first << "        ";
-        print_money(top_products[i].second);
-        cout << endl;
+    // Частичные итоги для --merge на другом узле
+    if (!partial_path.empty()) {
+        if (!write_partial(partial_path, stats, partial)) {
+            return 1;
+        }
+        cout << "Частичные итоги записаны в " << partial_path << endl;
     }
 
-    cout << endl;
+    // Индекс по артикулам для последующих запросов --query-sku
+    if (!build_index_path.empty()) {
+        SkuIndexStats index_stats;
+        if (!write_sku_index(build_index_path, orders, index_stats)) {
+            return 1;
+        }
+        cout << "Индекс записан в " << build_index_path << ": " << index_stats.sku_count << " артикулов, "
+             << index_stats.posting_count << " записей, " << index_stats.file_size / 1024 << " КБ" << endl;
+    }
 
     time_end = chrono::high_resolution_clock::now();
+    if (perf_enabled) calc_perf = perf_stop(counters);
     int calc_time = chrono::duration_cast<chrono::milliseconds>(time_end - time_start).count();
 
     // Итоговое время
@@ -892,6 +1364,21 @@ int main(int argc, char* argv[]) {
     cout << "ВСЕГО:            " << total_time << " мс" << endl;
     cout << endl;
 
+    if (pipelined) {
+        print_header("КОНВЕЙЕР ЗАГРУЗКИ");
+        print_load_stats(loaded);
+        cout << endl;
+    }
+
+    if (perf_enabled) {
+        print_header("АППАРАТНЫЕ СЧЁТЧИКИ");
+        print_perf_sample("Загрузка", load_perf, order_total);
+        print_perf_sample("Проверка", check_perf, order_total);
+        print_perf_sample("Расчёты", calc_perf, order_total);
+        cout << endl;
+        perf_close(counters);
+    }
+
     cout << "Готово!" << endl;
     cout << endl;
 
@@ -0,0 +1,423 @@
+#include "../include/analytics.h"
+#include "../include/metrics_pipeline.h"
+#include "../include/spill_table.h"
+#include <array>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+Money calculate_order_total(const Order& order) {
+    Money total = 0;
+    for (size_t i = 0; i < order.items.size(); i++) {
+        total += (Money)order.items[i].quantity * order.items[i].price;
+    }
+    return total;
+}
+
+string get_date(const string& date_time) {
+    if (date_time.length() >= 10) {
+        return date_time.substr(0, 10);  // Берем первые 10 символов
+    }
+    return date_time;
+}
+
+Money divide_money(Money total, long long count) {
+    if (count <= 0) return 0;
+    if (total >= 0) return (total * 2 + count) / (count * 2);
+    return -((-total * 2 + count) / (count * 2));
+}
+
+static const double SKETCH_GAMMA = (1 + QUANTILE_RELATIVE_ERROR) / (1 - QUANTILE_RELATIVE_ERROR);
+static const double SKETCH_LOG_GAMMA = log(SKETCH_GAMMA);
+
+void sketch_add(QuantileSketch& sketch, Money value) {
+    sketch.count++;
+    if (value <= 0) {
+        sketch.zero_count++;
+        return;
+    }
+
+    int key = (int)ceil(log((double)value) / SKETCH_LOG_GAMMA);
+    if (sketch.buckets.empty()) {
+        sketch.min_key = key;
+    }
+    else if (key < sketch.min_key) {
+        // Корзины расширяются вниз: сдвигаем имеющиеся
+        sketch.buckets.insert(sketch.buckets.begin(), sketch.min_key - key, 0);
+        sketch.min_key = key;
+    }
+    size_t index = key - sketch.min_key;
+    if (index >= sketch.buckets.size()) sketch.buckets.resize(index + 1, 0);
+    sketch.buckets[index]++;
+}
+
+void sketch_merge(QuantileSketch& sketch, const QuantileSketch& other) {
+    sketch.count += other.count;
+    sketch.zero_count += other.zero_count;
+    if (other.buckets.empty()) return;
+    if (sketch.buckets.empty()) {
+        sketch.buckets = other.buckets;
+        sketch.min_key = other.min_key;
+        return;
+    }
+
+    if (other.min_key < sketch.min_key) {
+        sketch.buckets.insert(sketch.buckets.begin(), sketch.min_key - other.min_key, 0);
+        sketch.min_key = other.min_key;
+    }
+    size_t offset = other.min_key - sketch.min_key;
+    if (offset + other.buckets.size() > sketch.buckets.size()) {
+        sketch.buckets.resize(offset + other.buckets.size(), 0);
+    }
+    for (size_t k = 0; k < other.buckets.size(); k++) {
+        sketch.buckets[offset + k] += other.buckets[k];
+    }
+}
+
+Money sketch_quantile(const QuantileSketch& sketch, double q) {
+    if (sketch.count == 0) return 0;
+
+    // Номер нужного значения в отсортированном ряду по ближайшему рангу:
+    // наименьшее значение, не меньше которого доля q заказов (ceil(q * n) - 1).
+    // Поправка 1e-9 не даёт ошибке округления в q * n поднять ранг на единицу
+    long long rank = (long long)ceil(q * sketch.count - 1e-9) - 1;
+    rank = min(max(rank, 0LL), sketch.count - 1);
+    if (rank < sketch.zero_count) return 0;
+
+    long long seen = sketch.zero_count;
+    for (size_t k = 0; k < sketch.buckets.size(); k++) {
+        seen += sketch.buckets[k];
+        if (seen > rank) {
+            // Середина корзины: 2 * gamma^key / (gamma + 1)
+            int key = sketch.min_key + (int)k;
+            return (Money)llround(2 * pow(SKETCH_GAMMA, key) / (SKETCH_GAMMA + 1));
+        }
+    }
+    return (Money)llround(pow(SKETCH_GAMMA, sketch.min_key + (int)sketch.buckets.size() - 1));
+}
+
+uint64_t distinct_hash(string_view text) {
+    // FNV-1a, затем перемешивание splitmix64: HyperLogLog смотрит и на
+    // старшие биты (номер регистра), и на младшие (серия нулей)
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+void hll_add(HyperLogLog& hll, uint64_t hash, int precision) {
+    if (hll.registers.empty()) {
+        hll.precision = precision;
+        hll.registers.assign((size_t)1 << precision, 0);
+    }
+    size_t index = hash >> (64 - hll.precision);
+    // Серия нулей в оставшихся битах; единица-ограничитель не даёт
+    // счёту выйти за 64 - precision
+    uint64_t rest = (hash << hll.precision) | ((uint64_t)1 << (hll.precision - 1));
+    uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+    if (rank > hll.registers[index]) hll.registers[index] = rank;
+}
+
+// Перевести скетч на меньшую точность. Младшие (precision - target) бит
+// старого номера регистра становятся началом хвоста хеша: если среди них
+// есть единица, ранг определяется ею, иначе к старому рангу добавляется
+// их число
+static HyperLogLog hll_fold(const HyperLogLog& hll, int target) {
+    HyperLogLog folded;
+    folded.precision = target;
+    folded.registers.assign((size_t)1 << target, 0);
+    int shift = hll.precision - target;
+    for (size_t k = 0; k < hll.registers.size(); k++) {
+        if (hll.registers[k] == 0) continue;
+        size_t low = k & (((size_t)1 << shift) - 1);
+        uint8_t rank = low != 0
+            ? (uint8_t)(shift - (63 - __builtin_clzll(low)))
+            : (uint8_t)(shift + hll.registers[k]);
+        uint8_t& slot = folded.registers[k >> shift];
+        if (rank > slot) slot = rank;
+    }
+    return folded;
+}
+
+void hll_merge(HyperLogLog& hll, const HyperLogLog& other) {
+    if (other.registers.empty()) return;
+    if (hll.registers.empty()) {
+        hll = other;
+        return;
+    }
+    // Разные точности: более точный скетч сводим к менее точному
+    if (hll.precision > other.precision) {
+        hll = hll_fold(hll, other.precision);
+    }
+    else if (other.precision > hll.precision) {
+        hll_merge(hll, hll_fold(other, hll.precision));
+        return;
+    }
+    for (size_t k = 0; k < hll.registers.size(); k++) {
+        hll.registers[k] = max(hll.registers[k], other.registers[k]);
+    }
+}
+
+long long hll_estimate(const HyperLogLog& hll) {
+    if (hll.registers.empty()) return 0;
+
+    double m = (double)hll.registers.size();
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : hll.registers) {
+        sum += ldexp(1.0, -r);
+        if (r == 0) zeros++;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+
+    // Мало значений: точнее считать по пустым регистрам
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+    return llround(estimate);
+}
+
+// Конвейер для маски метрик: невыбранные метрики заменены заглушками
+template <unsigned Metrics>
+using PipelineFor = MetricPipeline<
+    TotalsMetric,
+    conditional_t<(Metrics & METRIC_DAILY) != 0, DailyMetric, NoMetric<0>>,
+    conditional_t<(Metrics & METRIC_SKU) != 0, SkuMetric, NoMetric<1>>,
+    conditional_t<(Metrics & METRIC_HISTOGRAM) != 0, HistogramMetric, NoMetric<2>>,
+    conditional_t<(Metrics & METRIC_APPROX_SKU) != 0, ApproxSkuMetric, NoMetric<3>>,
+    conditional_t<(Metrics & METRIC_QUANTILES) != 0, QuantileMetric, NoMetric<4>>,
+    conditional_t<(Metrics & METRIC_DISTINCT) != 0, DistinctMetric, NoMetric<5>>
+>;
+
+typedef AnalyticsPart (*PipelineRunner)(const vector<Order>&, int, size_t);
+
+// Таблица заранее собранных конвейеров: индекс - маска метрик
+template <size_t... Masks>
+constexpr array<PipelineRunner, sizeof...(Masks)> make_runners(index_sequence<Masks...>) {
+    return {{ &run_pipeline<PipelineFor<Masks>>... }};
+}
+
+static constexpr auto PIPELINE_RUNNERS = make_runners(make_index_sequence<METRIC_MASK_COUNT>());
+
+AnalyticsPart aggregate_orders(const vector<Order>& orders, int threads, unsigned metrics, size_t approx_capacity,
+                               size_t memory_limit, int top_count) {
+    unsigned mask = metrics & (METRIC_MASK_COUNT - 1);
+    if (memory_limit == 0 || (mask & METRIC_SKU) == 0) {
+        return PIPELINE_RUNNERS[mask](orders, threads, approx_capacity);
+    }
+
+    // Остальные метрики - обычным конвейером, артикулы - в таблице с лимитом
+    AnalyticsPart result = PIPELINE_RUNNERS[mask & ~METRIC_SKU](orders, threads, approx_capacity);
+    spill_aggregate(orders, threads, memory_limit, top_count, result);
+    return result;
+}
+
+// Операции порционного расчёта для конкретного конвейера
+struct AccumulatorOps {
+    shared_ptr<void> (*create)();
+    void (*add)(void* state, const MetricSetup& setup, const vector<Order>& orders, size_t begin, size_t end);
+    void (*finish)(void* state, AnalyticsPart& result);
+};
+
+template <typename Pipeline>
+static shared_ptr<void> accumulator_create() {
+    return make_shared<Pipeline>();
+}
+
+template <typename Pipeline>
+static void accumulator_add(void* state, const MetricSetup& setup, const vector<Order>& orders,
+                            size_t begin, size_t end) {
+    Pipeline& pipeline = *static_cast<Pipeline*>(state);
+    pipeline.init(setup);
+    pipeline.add_range(orders, begin, end);
+}
+
+template <typename Pipeline>
+static void accumulator_finish(void* state, AnalyticsPart& result) {
+    Pipeline& pipeline = *static_cast<Pipeline*>(state);
+    pipeline.export_to(result);
+    pipeline = Pipeline();
+}
+
+template <size_t... Masks>
+constexpr array<AccumulatorOps, sizeof...(Masks)> make_accumulator_ops(index_sequence<Masks...>) {
+    return {{ { &accumulator_create<PipelineFor<Masks>>,
+                &accumulator_add<PipelineFor<Masks>>,
+                &accumulator_finish<PipelineFor<Masks>> }... }};
+}
+
+static constexpr auto ACCUMULATOR_OPS = make_accumulator_ops(make_index_sequence<METRIC_MASK_COUNT>());
+
+AnalyticsAccumulator make_accumulator(unsigned metrics, size_t approx_capacity, size_t memory_limit, int top_count) {
+    AnalyticsAccumulator acc;
+    acc.metrics = metrics & (METRIC_MASK_COUNT - 1);
+    acc.approx_capacity = approx_capacity;
+    if (memory_limit > 0 && (acc.metrics & METRIC_SKU) != 0) {
+        acc.metrics &= ~METRIC_SKU;
+        acc.spill = make_shared<SpillTable>(memory_limit, top_count);
+    }
+    acc.state = ACCUMULATOR_OPS[acc.metrics].create();
+    return acc;
+}
+
+void accumulate_orders(AnalyticsAccumulator& acc, const vector<Order>& orders, size_t begin, size_t end) {
+    MetricSetup setup;
+    setup.sku_total = sku_count();
+    setup.approx_capacity = acc.approx_capacity;
+    ACCUMULATOR_OPS[acc.metrics].add(acc.state.get(), setup, orders, begin, end);
+    if (acc.spill) spill_add_orders(*acc.spill, orders, begin, end);
+}
+
+AnalyticsPart finish_accumulator(AnalyticsAccumulator& acc) {
+    AnalyticsPart result;
+    ACCUMULATOR_OPS[acc.metrics].finish(acc.state.get(), result);
+    if (acc.spill) spill_finish({acc.spill.get()}, result);
+    return result;
+}
+
+// Счётчики приблизительного топа обратно в кучу (для слияния)
+static ApproxSkuMetric approx_from(const AnalyticsPart& part) {
+    ApproxSkuMetric metric;
+    metric.capacity = part.approx_capacity;
+    for (const ApproxCounter& c : part.approx_top) {
+        metric.push(c);
+    }
+    return metric;
+}
+
+void merge_analytics(AnalyticsPart& result, AnalyticsPart& part) {
+    result.order_count += part.order_count;
+    result.item_count += part.item_count;
+    result.total_revenue += part.total_revenue;
+    result.spill_count += part.spill_count;
+    result.spilled_bytes += part.spilled_bytes;
+
+    for (auto& p : part.daily_revenue) {
+        result.daily_revenue[p.first] += p.second;
+    }
+
+    if (part.product_revenue.size() > result.product_revenue.size()) {
+        result.product_revenue.resize(part.product_revenue.size(), 0);
+        result.product_lines.resize(part.product_revenue.size(), 0);
+    }
+    for (size_t k = 0; k < part.product_revenue.size(); k++) {
+        result.product_revenue[k] += part.product_revenue[k];
+        result.product_lines[k] += part.product_lines[k];
+    }
+
+    if (part.order_value_histogram.size() > result.order_value_histogram.size()) {
+        result.order_value_histogram.resize(part.order_value_histogram.size(), 0);
+    }
+    for (size_t k = 0; k < part.order_value_histogram.size(); k++) {
+        result.order_value_histogram[k] += part.order_value_histogram[k];
+    }
+
+    if (part.approx_capacity > 0) {
+        if (result.approx_capacity == 0) {
+            result.approx_top = part.approx_top;
+            result.approx_capacity = part.approx_capacity;
+        } else {
+            ApproxSkuMetric merged = approx_from(result);
+            ApproxSkuMetric other = approx_from(part);
+            merged.merge(other);
+            merged.export_to(result);
+        }
+    }
+
+    sketch_merge(result.order_value_sketch, part.order_value_sketch);
+    hll_merge(result.distinct_orders, part.distinct_orders);
+    hll_merge(result.distinct_skus, part.distinct_skus);
+    for (auto& p : part.daily_distinct_skus) {
+        hll_merge(result.daily_distinct_skus[p.first], p.second);
+    }
+}
+
+vector<pair<string, Money>> top_products_from(const AnalyticsPart& part, int top_count) {
+    // С лимитом памяти топ уже отобран и упорядочен (spill_finish)
+    if (!part.product_top.empty()) {
+        vector<pair<string, Money>> products;
+        for (size_t k = 0; k < part.product_top.size() && k < (size_t)max(top_count, 0); k++) {
+            products.push_back(make_pair(sku_name(part.product_top[k].first), part.product_top[k].second));
+        }
+        return products;
+    }
+
+    // Разреженные суммы (лимит памяти и частичные итоги): топ отбирается из них
+    if (!part.product_totals.empty()) {
+        vector<SkuTotal> totals = part.product_totals;
+        auto better = [](const SkuTotal& a, const SkuTotal& b) {
+            if (a.revenue != b.revenue) return a.revenue > b.revenue;
+            return sku_name(a.sku) < sku_name(b.sku);
+        };
+        size_t n = top_count > 0 ? min(totals.size(), (size_t)top_count) : 0;
+        partial_sort(totals.begin(), totals.begin() + n, totals.end(), better);
+
+        vector<pair<string, Money>> products;
+        for (size_t k = 0; k < n; k++) {
+            products.push_back(make_pair(sku_name(totals[k].sku), totals[k].revenue));
+        }
+        return products;
+    }
+
+    // Номера артикулов, которые встречались в заказах
+    vector<SkuId> ids;
+    for (size_t k = 0; k < part.product_lines.size(); k++) {
+        if (part.product_lines[k] > 0) ids.push_back((SkuId)k);
+    }
+
+    // По выручке (от большего к меньшему), при равенстве - по тексту артикула,
+    // чтобы порядок не зависел от порядка появления артикулов в словаре
+    auto by_revenue = [&part](SkuId a, SkuId b) {
+        if (part.product_revenue[a] != part.product_revenue[b]) {
+            return part.product_revenue[a] > part.product_revenue[b];
+        }
+        return sku_name(a) < sku_name(b);
+    };
+
+    // Сортируем только топ N
+    size_t n = top_count > 0 ? min(ids.size(), (size_t)top_count) : 0;
+    partial_sort(ids.begin(), ids.begin() + n, ids.end(), by_revenue);
+
+    vector<pair<string, Money>> products;
+    for (size_t k = 0; k < n; k++) {
+        products.push_back(make_pair(sku_name(ids[k]), part.product_revenue[ids[k]]));
+    }
+
+    return products;
+}
+
+vector<ApproxCounter> approx_top_products(const AnalyticsPart& part, int top_count) {
+    vector<ApproxCounter> counters = part.approx_top;
+    auto by_count = [](const ApproxCounter& a, const ApproxCounter& b) {
+        if (a.count != b.count) return a.count > b.count;
+        return a.sku < b.sku;
+    };
+
+    size_t n = top_count > 0 ? min(counters.size(), (size_t)top_count) : 0;
+    partial_sort(counters.begin(), counters.begin() + n, counters.end(), by_count);
+    counters.resize(n);
+    return counters;
+}
+
+map<string, Money> calculate_daily_revenue(const vector<Order>& orders, int threads) {
+    return aggregate_orders(orders, threads, METRIC_DAILY).daily_revenue;
+}
+
+Money calculate_average_check(const vector<Order>& orders, int threads) {
+    if (orders.empty()) return 0;
+    AnalyticsPart part = aggregate_orders(orders, threads, 0);
+    return divide_money(part.total_revenue, part.order_count);
+}
+
+vector<pair<string, Money>> find_top_products(const vector<Order>& orders, int top_count, int threads) {
+    return top_products_from(aggregate_orders(orders, threads, METRIC_SKU), top_count);
+}
@@ -0,0 +1,208 @@
+#include "../include/dedup.h"
+#include "../include/analytics.h"
+#include <iostream>
+
+using namespace std;
+
+bool parse_dedup_mode(const string& name, DedupMode& mode) {
+    if (name == "report") mode = DEDUP_REPORT;
+    else if (name == "drop") mode = DEDUP_FIRST;
+    else if (name == "last") mode = DEDUP_LAST;
+    else return false;
+    return true;
+}
+
+bool dedup_streams(const DedupOptions& options) {
+    return !options.bloom && (options.mode == DEDUP_REPORT || options.mode == DEDUP_FIRST);
+}
+
+bool encode_order_id(string_view id, uint64_t& key) {
+    // Биты: 63 - метка (ключ не бывает нулём), 48..62 - три буквы по 5 бит,
+    // 44..47 - число цифр (ведущие нули различаются), 0..43 - число
+    size_t k = 0;
+    uint64_t prefix = 0;
+    while (k < id.size() && id[k] >= 'A' && id[k] <= 'Z') {
+        if (k == 3) return false;
+        prefix = prefix * 32 + (id[k] - 'A' + 1);
+        k++;
+    }
+
+    size_t digits = id.size() - k;
+    if (digits == 0 || digits > 13) return false;
+    uint64_t number = 0;
+    for (; k < id.size(); k++) {
+        if (id[k] < '0' || id[k] > '9') return false;
+        number = number * 10 + (id[k] - '0');
+    }
+
+    key = (1ull << 63) | (prefix << 48) | ((uint64_t)digits << 44) | number;
+    return true;
+}
+
+// Номер слота для ключа (перемешивание splitmix64)
+static size_t slot_of(uint64_t key, size_t mask) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key & mask;
+}
+
+// Вставить ключ в таблицу с линейным пробированием. false - уже был
+static bool slots_insert(vector<uint64_t>& slots, uint64_t key) {
+    size_t mask = slots.size() - 1;
+    size_t k = slot_of(key, mask);
+    while (slots[k] != 0) {
+        if (slots[k] == key) return false;
+        k = (k + 1) & mask;
+    }
+    slots[k] = key;
+    return true;
+}
+
+bool OrderIdSet::insert(const string& id) {
+    uint64_t key;
+    if (!encode_order_id(id, key)) {
+        return other.insert(id).second;
+    }
+
+    // Заполнение не больше половины: удваиваем и переносим
+    if ((used + 1) * 2 > slots.size()) {
+        vector<uint64_t> grown(max<size_t>(1024, slots.size() * 2), 0);
+        for (uint64_t old : slots) {
+            if (old != 0) slots_insert(grown, old);
+        }
+        slots.swap(grown);
+    }
+    if (!slots_insert(slots, key)) return false;
+    used++;
+    return true;
+}
+
+bool OrderIdSet::contains(const string& id) const {
+    uint64_t key;
+    if (!encode_order_id(id, key)) {
+        return other.count(id) > 0;
+    }
+    if (slots.empty()) return false;
+
+    size_t mask = slots.size() - 1;
+    size_t k = slot_of(key, mask);
+    while (slots[k] != 0) {
+        if (slots[k] == key) return true;
+        k = (k + 1) & mask;
+    }
+    return false;
+}
+
+size_t OrderIdSet::memory_bytes() const {
+    size_t bytes = slots.size() * sizeof(uint64_t);
+    for (const string& id : other) {
+        bytes += sizeof(string) + id.size() + 2 * sizeof(void*);
+    }
+    return bytes;
+}
+
+// Фильтр Блума на bits битов (кратно 64)
+struct BloomFilter {
+    vector<uint64_t> words;
+
+    explicit BloomFilter(size_t bits) : words(max<size_t>(1, (bits + 63) / 64), 0) {}
+
+    // Отметить номер. true - все биты уже стояли (номер, возможно, был)
+    bool test_and_set(const string& id) {
+        uint64_t hash = distinct_hash(id);
+        uint64_t h1 = hash & 0xffffffffu;
+        uint64_t h2 = (hash >> 32) | 1;
+        uint64_t total = words.size() * 64;
+        bool seen = true;
+        for (int k = 0; k < BLOOM_HASHES; k++) {
+            uint64_t bit = (h1 + k * h2) % total;
+            uint64_t flag = 1ull << (bit & 63);
+            if ((words[bit >> 6] & flag) == 0) {
+                seen = false;
+                words[bit >> 6] |= flag;
+            }
+        }
+        return seen;
+    }
+};
+
+DedupStats deduplicate_orders(vector<Order>& orders, const DedupOptions& options) {
+    DedupStats stats;
+    if (options.mode == DEDUP_OFF) return stats;
+
+    // Для "оставить последний" идём с конца: первое встреченное
+    // вхождение и есть последнее по порядку файлов
+    bool backward = options.mode == DEDUP_LAST;
+    size_t n = orders.size();
+    auto at = [&](size_t k) -> const Order& { return orders[backward ? n - 1 - k : k]; };
+
+    // С фильтром Блума точно проверяются только отобранные им номера
+    OrderIdSet candidates;
+    if (options.bloom) {
+        BloomFilter filter(n * BLOOM_BITS_PER_ID);
+        for (size_t k = 0; k < n; k++) {
+            const Order& order = at(k);
+            if (!order.id.empty() && filter.test_and_set(order.id)) {
+                candidates.insert(order.id);
+            }
+        }
+        stats.candidates = candidates.used + candidates.other.size();
+        stats.memory_bytes = filter.words.size() * sizeof(uint64_t) + candidates.memory_bytes();
+    }
+
+    OrderIdSet seen;
+    vector<char> keep(n, 1);
+    for (size_t k = 0; k < n; k++) {
+        const Order& order = at(k);
+        if (order.id.empty()) continue;
+        stats.checked++;
+        if (options.bloom && !candidates.contains(order.id)) continue;
+        if (seen.insert(order.id)) continue;
+
+        stats.duplicates++;
+        if (stats.examples.size() < DEDUP_EXAMPLES) stats.examples.push_back(order.id);
+        if (options.mode != DEDUP_REPORT) {
+            keep[backward ? n - 1 - k : k] = 0;
+        }
+    }
+    stats.memory_bytes += seen.memory_bytes();
+
+    if (options.mode != DEDUP_REPORT && stats.duplicates > 0) {
+        size_t write = 0;
+        for (size_t k = 0; k < n; k++) {
+            if (!keep[k]) continue;
+            if (write != k) orders[write] = move(orders[k]);
+            write++;
+        }
+        stats.removed = n - write;
+        orders.resize(write);
+    }
+    return stats;
+}
+
+void print_dedup_stats(const DedupStats& stats, const DedupOptions& options) {
+    if (stats.duplicates == 0) {
+        cout << "  Повторных заказов нет (проверено " << stats.checked << ", память "
+             << stats.memory_bytes / 1024 << " КБ)" << endl;
+        return;
+    }
+
+    cout << "  Повторных заказов: " << stats.duplicates << " из " << stats.checked;
+    if (options.mode == DEDUP_FIRST) cout << ", удалены (оставлен первый)";
+    else if (options.mode == DEDUP_LAST) cout << ", удалены (оставлен последний)";
+    else cout << ", оставлены (выручка может быть завышена)";
+    cout << endl;
+
+    cout << "  Номера:";
+    for (const string& id : stats.examples) cout << " " << id;
+    if (stats.duplicates > (long long)stats.examples.size()) cout << " ...";
+    cout << endl;
+
+    if (options.bloom) {
+        cout << "  Фильтр Блума отобрал номеров: " << stats.candidates << endl;
+    }
+    cout << "  Память на проверку: " << stats.memory_bytes / 1024 << " КБ" << endl;
+}
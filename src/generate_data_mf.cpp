@@ -8,6 +8,9 @@
 #include <iomanip>
 #include <sstream>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -28,6 +31,136 @@ string generate_sku() {
            static_cast<char>('A' + (num_dist(gen) % 26));
 }
 
+// Артикул номер k каталога: префикс и число вместе уникальны
+string catalog_sku(int k) {
+    const string prefixes[] = { "PROD", "SKU", "ITEM", "ART", "BOLT" };
+    return prefixes[k % 5] + "-" + to_string(100 + k / 5) + static_cast<char>('A' + (k * 7) % 26);
+}
+
+// Профиль спроса по часам суток (UTC): ночью мало, пики в обед и вечером
+const double HOUR_WEIGHTS[24] = {
+    2, 1, 1, 1, 1, 2, 4, 6, 8, 9, 10, 11, 12, 11, 10, 10, 10, 11, 13, 14, 13, 10, 7, 4
+};
+
+// Профиль по дням недели (понедельник..воскресенье): к выходным больше
+const double WEEKDAY_WEIGHTS[7] = { 10, 10, 10, 11, 13, 15, 14 };
+
+// Всё, что нужно для генерации по GeneratorOptions (строится один раз)
+struct OrderSampler {
+    GeneratorOptions options;
+    vector<double> sku_cdf;             // Закон Ципфа: накопленные вероятности по рангу артикула
+    discrete_distribution<> day_dist;   // С сезонностью: день периода
+    discrete_distribution<> hour_dist;  //                и час
+    time_t last_day = 0;                // Последний день периода: сейчас или, с seed, GENERATOR_SEED_LAST_DAY
+    time_t first_day = 0;               // Полночь (UTC) первого дня периода
+};
+
+OrderSampler make_sampler(const GeneratorOptions& options) {
+    OrderSampler sampler;
+    sampler.options = options;
+    sampler.last_day = options.seed != 0 ? (time_t)GENERATOR_SEED_LAST_DAY : time(nullptr);
+
+    if (options.zipf_exponent > 0 && options.catalog_size > 0) {
+        sampler.sku_cdf.resize(options.catalog_size);
+        double sum = 0;
+        for (int k = 0; k < options.catalog_size; k++) {
+            sum += 1.0 / pow(k + 1, options.zipf_exponent);
+            sampler.sku_cdf[k] = sum;
+        }
+        for (double& p : sampler.sku_cdf) {
+            p /= sum;
+        }
+    }
+
+    if (options.seasonality) {
+        // Те же days + 1 дней, что и без сезонности (от -days до сегодня)
+        time_t now = sampler.last_day;
+        sampler.first_day = now - now % 86400 - (time_t)options.days * 86400;
+        vector<double> weights;
+        for (int d = 0; d <= options.days; d++) {
+            time_t day = sampler.first_day + (time_t)d * 86400;
+            tm day_info;
+            gmtime_r(&day, &day_info);
+            weights.push_back(WEEKDAY_WEIGHTS[(day_info.tm_wday + 6) % 7]);
+        }
+        sampler.day_dist = discrete_distribution<>(weights.begin(), weights.end());
+        sampler.hour_dist = discrete_distribution<>(begin(HOUR_WEIGHTS), end(HOUR_WEIGHTS));
+    }
+    return sampler;
+}
+
+// Артикул: случайный, равномерно из каталога или по рангу Ципфа
+string sample_sku(const OrderSampler& sampler) {
+    int catalog = sampler.options.catalog_size;
+    if (catalog <= 0) return generate_sku();
+
+    int rank;
+    if (!sampler.sku_cdf.empty()) {
+        uniform_real_distribution<> unit(0.0, 1.0);
+        rank = lower_bound(sampler.sku_cdf.begin(), sampler.sku_cdf.end(), unit(gen)) - sampler.sku_cdf.begin();
+        rank = min(rank, catalog - 1);
+    }
+    else {
+        uniform_int_distribution<> rank_dist(0, catalog - 1);
+        rank = rank_dist(gen);
+    }
+    return catalog_sku(rank);
+}
+
+// Число по распределению; геометрический хвост за max перевыбирается
+int sample_count(const CountDistribution& dist) {
+    if (dist.kind == COUNT_GEOMETRIC) {
+        geometric_distribution<> tail(1.0 / (dist.mean - dist.min + 1));
+        int value;
+        do {
+            value = dist.min + tail(gen);
+        } while (value > dist.max);
+        return value;
+    }
+    uniform_int_distribution<> uniform(dist.min, dist.max);
+    return uniform(gen);
+}
+
+bool parse_count_distribution(const string& spec, CountDistribution& dist) {
+    try {
+        if (spec.compare(0, 5, "geom:") == 0) {
+            size_t colon = spec.find(':', 5);
+            double mean = stod(spec.substr(5, colon == string::npos ? string::npos : colon - 5));
+            int max_value = colon == string::npos ? 100 : stoi(spec.substr(colon + 1));
+            if (mean < dist.min || max_value < mean) return false;
+            dist.kind = COUNT_GEOMETRIC;
+            dist.mean = mean;
+            dist.max = max_value;
+            return true;
+        }
+
+        size_t dash = spec.find('-');
+        if (dash == string::npos) return false;
+        int low = stoi(spec.substr(0, dash));
+        int high = stoi(spec.substr(dash + 1));
+        if (low < 1 || high < low) return false;    // 0 позиций или штук - заведомо неверный заказ
+        dist.kind = COUNT_UNIFORM;
+        dist.min = low;
+        dist.max = high;
+        return true;
+    }
+    catch (const exception&) {
+        return false;
+    }
+}
+
+// Описание распределения для вывода
+string describe_count(const CountDistribution& dist) {
+    ostringstream oss;
+    if (dist.kind == COUNT_GEOMETRIC) {
+        oss << "геометрическое, среднее " << dist.mean << " (" << dist.min << "-" << dist.max << ")";
+    }
+    else {
+        oss << "равномерно " << dist.min << "-" << dist.max;
+    }
+    return oss.str();
+}
+
 // Генератор ID заказа
 string generate_order_id(int index) {
     ostringstream oss;
@@ -35,13 +168,8 @@ string generate_order_id(int index) {
     return oss.str();
 }
 
-// Генератор даты и времени в формате ISO 8601
-string generate_timestamp(int days_offset = 0, int hours_offset = 0) {
-    time_t now = time(nullptr);
-    now += days_offset * 24 * 3600 + hours_offset * 3600;
-
-    tm* tm_info = localtime(&now);
-
+// Дата и время в формате ISO 8601
+string format_timestamp(const tm* tm_info) {
     ostringstream oss;
     oss << (1900 + tm_info->tm_year) << "-"
         << setfill('0') << setw(2) << (1 + tm_info->tm_mon) << "-"
@@ -53,6 +181,25 @@ string generate_timestamp(int days_offset = 0, int hours_offset = 0) {
     return oss.str();
 }
 
+// Генератор даты и времени в формате ISO 8601 (UTC, как и суффикс Z)
+// со сдвигом от конца периода
+string generate_timestamp(time_t last_day, int days_offset = 0, int hours_offset = 0) {
+    time_t t = last_day + (time_t)days_offset * 86400 + hours_offset * 3600;
+    tm tm_info;
+    gmtime_r(&t, &tm_info);
+    return format_timestamp(&tm_info);
+}
+
+// Метка времени с сезонностью: день по дням недели, час по профилю суток
+string seasonal_timestamp(OrderSampler& sampler) {
+    uniform_int_distribution<> second_dist(0, 3599);
+    time_t t = sampler.first_day + (time_t)sampler.day_dist(gen) * 86400 +
+               sampler.hour_dist(gen) * 3600 + second_dist(gen);
+    tm tm_info;
+    gmtime_r(&t, &tm_info);
+    return format_timestamp(&tm_info);
+}
+
 // Экранирование строк для JSON
 string escape_json_string(const string& str) {
     string result = "";
@@ -67,16 +214,15 @@ string escape_json_string(const string& str) {
 }
 
 // Генерация одного товара
-string generate_item(bool with_errors = false) {
+string generate_item(const OrderSampler& sampler) {
     uniform_real_distribution<> price_dist(10.0, 5000.0);
-    uniform_int_distribution<> qty_dist(1, 50);
 
-    string sku = generate_sku();
-    int qty = qty_dist(gen);
+    string sku = sample_sku(sampler);
+    int qty = sample_count(sampler.options.quantity);
     double price = price_dist(gen);
 
     // Намеренные ошибки для тестирования
-    if (with_errors) {
+    if (sampler.options.with_errors) {
         uniform_int_distribution<> error_type(0, 3);
         int error = error_type(gen);
 
@@ -106,15 +252,14 @@ string generate_item(bool with_errors = false) {
 }
 
 // Генерация одного заказа
-string generate_order(int index, bool with_errors = false) {
-    uniform_int_distribution<> items_count_dist(1, 10);
-    uniform_int_distribution<> days_dist(-30, 0);
+string generate_order(int index, OrderSampler& sampler) {
+    uniform_int_distribution<> days_dist(-sampler.options.days, 0);
     uniform_int_distribution<> hours_dist(0, 23);
 
-    int items_count = items_count_dist(gen);
+    int items_count = sample_count(sampler.options.items);
 
     // Намеренные ошибки для тестирования
-    if (with_errors) {
+    if (sampler.options.with_errors) {
         uniform_int_distribution<> error_type(0, 2);
         int error = error_type(gen);
 
@@ -126,12 +271,14 @@ string generate_order(int index, bool with_errors = false) {
     ostringstream oss;
     oss << "{";
     oss << "\"id\":\"" << generate_order_id(index) << "\",";
-    oss << "\"ts\":\"" << generate_timestamp(days_dist(gen), hours_dist(gen)) << "\",";
+    string ts = sampler.options.seasonality ? seasonal_timestamp(sampler)
+                                            : generate_timestamp(sampler.last_day, days_dist(gen), hours_dist(gen));
+    oss << "\"ts\":\"" << ts << "\",";
     oss << "\"items\":[";
 
     for (int i = 0; i < items_count; i++) {
         if (i > 0) oss << ",";
-        oss << generate_item(with_errors);
+        oss << generate_item(sampler);
     }
 
     oss << "]}";
@@ -152,11 +299,29 @@ bool create_directory(const std::string& path) {
 
 // Генерация отдельных JSON файлов
 void generate_separate_files(const string& base_dir, int count, bool with_errors) {
+    GeneratorOptions options;
+    options.with_errors = with_errors;
+    generate_separate_files(base_dir, count, options);
+}
+
+void generate_separate_files(const string& base_dir, int count, const GeneratorOptions& options) {
     cout << "Генерация отдельных JSON файлов" << endl;
     cout << "Директория: " << base_dir << endl;
     cout << "Количество файлов: " << count << endl;
-    cout << "Режим: " << (with_errors ? "с ошибками" : "корректные данные") << endl;
+    cout << "Режим: " << (options.with_errors ? "с ошибками" : "корректные данные") << endl;
+    cout << "Артикулы: ";
+    if (options.catalog_size <= 0) cout << "случайные";
+    else if (options.zipf_exponent > 0) cout << "каталог " << options.catalog_size << ", закон Ципфа s=" << options.zipf_exponent;
+    else cout << "каталог " << options.catalog_size << ", равномерно";
     cout << endl;
+    cout << "Позиций в заказе: " << describe_count(options.items) << endl;
+    cout << "Количество: " << describe_count(options.quantity) << endl;
+    cout << "Период: " << options.days << " дней" << (options.seasonality ? ", сезонность по дням недели и часам" : "")
+         << endl;
+    cout << endl;
+
+    if (options.seed != 0) gen.seed(options.seed);
+    OrderSampler sampler = make_sampler(options);
 
     // Создаём базовую директорию
     if (!create_directory(base_dir)) {
@@ -178,7 +343,7 @@ void generate_separate_files(const string& base_dir, int count, bool with_errors
         }
 
         file << "[\n";
-        file << generate_order(i, with_errors);
+        file << generate_order(i, sampler);
         file << "\n]";
         file.close();
 
@@ -213,6 +378,18 @@ void print_help() {
     cout << "  --count N       - Количество файлов" << endl;
     cout << "  --errors        - Включить генерацию ошибок" << endl;
     cout << endl;
+    cout << "Распределения (для бенчмарков, похожих на настоящий поток):" << endl;
+    cout << "  --catalog N     - Каталог из N артикулов (по умолчанию артикулы случайные)" << endl;
+    cout << "  --zipf S        - Популярность артикулов по закону Ципфа с показателем S" << endl;
+    cout << "                    (каталог по умолчанию " << ZIPF_DEFAULT_CATALOG << ")" << endl;
+    cout << "  --items A-B     - Позиций в заказе равномерно от A до B, A >= 1 (по умолчанию 1-10)" << endl;
+    cout << "  --items geom:M[:MAX] - Геометрически со средним M (до MAX, по умолчанию 100)" << endl;
+    cout << "  --qty A-B | geom:M[:MAX] - Количество товара в позиции (по умолчанию 1-50)" << endl;
+    cout << "  --days N        - Период: последние N дней (по умолчанию 30)" << endl;
+    cout << "  --seasonality   - Больше заказов к выходным, днём и вечером, меньше ночью" << endl;
+    cout << "  --seed N        - Зерно генератора: одинаковые данные при повторном запуске" << endl;
+    cout << "                    (последний день периода тогда 2026-01-01 UTC, а не сегодня)" << endl;
+    cout << endl;
     cout << "Пресеты:" << endl;
     cout << "  small           - 100 файлов" << endl;
     cout << "  medium          - 1,000 файлов" << endl;
@@ -224,6 +401,7 @@ void print_help() {
     cout << "  ./src/generate_data --preset small" << endl;
     cout << "  ./src/generate_data --output data/orders --count 500" << endl;
     cout << "  ./src/generate_data --output data/bad --count 100 --errors" << endl;
+    cout << "  ./src/generate_data --output data/zipf --count 10000 --zipf 1.1 --items geom:3 --seasonality" << endl;
     cout << endl;
     cout << "ВАЖНО:" << endl;
     cout << "  100,000 файлов займёт ~30-50 МБ места на диске" << endl;
@@ -239,7 +417,7 @@ void generateJSON(int argc, char* argv[]) {
 
     string output_dir = "";
     int count = 0;
-    bool with_errors = false;
+    GeneratorOptions options;
     string preset = "";
 
     // Парсинг аргументов
@@ -263,7 +441,45 @@ void generateJSON(int argc, char* argv[]) {
             }
         }
         else if (arg == "--errors") {
-            with_errors = true;
+            options.with_errors = true;
+        }
+        else if (arg == "--catalog") {
+            if (i + 1 < argc) {
+                options.catalog_size = max(1, stoi(argv[i + 1]));
+                i++;
+            }
+        }
+        else if (arg == "--zipf") {
+            if (i + 1 < argc) {
+                options.zipf_exponent = stod(argv[i + 1]);
+                i++;
+            }
+        }
+        else if (arg == "--items" || arg == "--qty") {
+            if (i + 1 < argc) {
+                CountDistribution& dist = arg == "--items" ? options.items : options.quantity;
+                if (!parse_count_distribution(argv[i + 1], dist)) {
+                    cerr << "Ошибка: неверное распределение " << arg << " " << argv[i + 1]
+                         << " (нужно A-B при 1 <= A <= B или geom:СРЕДНЕЕ[:МАКС])" << endl;
+                    return;
+                }
+                i++;
+            }
+        }
+        else if (arg == "--days") {
+            if (i + 1 < argc) {
+                options.days = max(0, stoi(argv[i + 1]));
+                i++;
+            }
+        }
+        else if (arg == "--seasonality") {
+            options.seasonality = true;
+        }
+        else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                options.seed = (unsigned)stoul(argv[i + 1]);
+                i++;
+            }
         }
         else if (arg == "--preset" || arg == "-p") {
             if (i + 1 < argc) {
@@ -277,6 +493,10 @@ void generateJSON(int argc, char* argv[]) {
 
     cout << "  ГЕНЕРАТОР ОТДЕЛЬНЫХ JSON ФАЙЛОВ" << endl;
 
+    if (options.zipf_exponent > 0 && options.catalog_size == 0) {
+        options.catalog_size = ZIPF_DEFAULT_CATALOG;
+    }
+
     cout << endl;
 
     // Обработка пресетов
@@ -313,7 +533,7 @@ void generateJSON(int argc, char* argv[]) {
     }
         // Кастомные параметры
     else if (!output_dir.empty() && count > 0) {
-        generate_separate_files(output_dir, count, with_errors);
+        generate_separate_files(output_dir, count, options);
     }
     else {
         cerr << "Ошибка: укажите --output и --count или используйте --preset" << endl;
@@ -0,0 +1,74 @@
+#include "../include/gzip_reader.h"
+#include <zlib.h>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+// Во сколько раз буфер под текст может превышать сжатые данные заранее
+// (JSON заказов сжимается примерно в 5-10 раз)
+const size_t GZIP_RESERVE_RATIO = 16;
+
+bool is_gzip(const string& data) {
+    return data.size() >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+}
+
+bool gunzip(const string& compressed, string& text) {
+    text.clear();
+
+    // В конце gzip - размер распакованных данных (по модулю 2^32):
+    // для одной части это точный размер буфера. Поле ничем не проверено,
+    // поэтому подсказка не больше GZIP_RESERVE_RATIO размеров сжатых данных:
+    // повреждённый файл не займёт гигабайты, а больший текст просто дорастёт
+    if (compressed.size() >= 18) {
+        const unsigned char* tail = (const unsigned char*)compressed.data() + compressed.size() - 4;
+        uint32_t size = tail[0] | (tail[1] << 8) | (tail[2] << 16) | ((uint32_t)tail[3] << 24);
+        text.reserve(min<size_t>(size, compressed.size() * GZIP_RESERVE_RATIO));
+    }
+
+    z_stream stream = {};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) return false;   // 16 - формат gzip
+    stream.next_in = (Bytef*)compressed.data();
+    stream.avail_in = (uInt)compressed.size();
+
+    char chunk[65536];
+    int status = Z_OK;
+    while (true) {
+        stream.next_out = (Bytef*)chunk;
+        stream.avail_out = sizeof(chunk);
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END) break;
+        text.append(chunk, sizeof(chunk) - stream.avail_out);
+
+        if (status == Z_STREAM_END) {
+            // Следующая склеенная часть или конец данных
+            if (stream.avail_in == 0) break;
+            if (inflateReset(&stream) != Z_OK) break;
+        }
+        else if (stream.avail_in == 0 && stream.avail_out != 0) {
+            status = Z_DATA_ERROR;      // Данные обрезаны
+            break;
+        }
+    }
+    inflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+bool read_text_file(const string& path, string& text) {
+    text.clear();
+
+    // gzread читает и несжатые файлы как есть
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    gzbuffer(file, 1 << 18);
+
+    char chunk[65536];
+    int n;
+    while ((n = gzread(file, chunk, sizeof(chunk))) > 0) {
+        text.append(chunk, n);
+    }
+    int error = 0;
+    gzerror(file, &error);
+    gzclose(file);
+    return n == 0 && error == Z_OK;
+}
@@ -0,0 +1,165 @@
+#include "../include/input_files.h"
+#include "../include/segment_store.h"
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <glob.h>
+
+using namespace std;
+
+bool is_orders_file(const string& filename) {
+    return filename.find(".json") != string::npos || is_segment_file(filename);
+}
+
+// Общее состояние обхода: стек ещё не прочитанных директорий
+struct DirectoryWalk {
+    mutex lock;
+    condition_variable changed;
+    vector<string> pending;     // Директории, которые ещё надо прочитать
+    size_t active = 0;          // Сколько директорий читается прямо сейчас
+    vector<string> files;
+};
+
+// Прочитать одну директорию: файлы в found, поддиректории в subdirs.
+// Ссылки на директории не обходятся (как find по умолчанию), чтобы не зациклиться
+static void scan_directory(const string& dir_path, vector<string>& found, vector<string>& subdirs) {
+    DIR* dir = opendir(dir_path.c_str());
+    if (dir == nullptr) {
+        cerr << "Предупреждение: не могу открыть директорию " << dir_path << endl;
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+
+        string path = dir_path + "/" + name;
+        unsigned char type = entry->d_type;
+
+        // Тип неизвестен (некоторые файловые системы) или ссылка - спрашиваем stat
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            struct stat statbuf;
+            if (lstat(path.c_str(), &statbuf) != 0) continue;
+            if (S_ISDIR(statbuf.st_mode)) type = DT_DIR;
+            else if (S_ISLNK(statbuf.st_mode)) {
+                type = (stat(path.c_str(), &statbuf) == 0 && S_ISREG(statbuf.st_mode)) ? DT_REG : DT_LNK;
+            }
+            else if (S_ISREG(statbuf.st_mode)) type = DT_REG;
+        }
+
+        if (type == DT_DIR) {
+            subdirs.push_back(path);
+        }
+        else if (type == DT_REG && is_orders_file(name)) {
+            found.push_back(path);
+        }
+    }
+    closedir(dir);
+}
+
+// Поток обхода: берёт директорию со стека, найденные поддиректории кладёт
+// обратно. Работа кончается, когда стек пуст и никто ничего не читает
+static void walk_worker(DirectoryWalk& walk) {
+    vector<string> found;
+    while (true) {
+        string dir_path;
+        {
+            unique_lock<mutex> guard(walk.lock);
+            walk.changed.wait(guard, [&walk]() { return !walk.pending.empty() || walk.active == 0; });
+            if (walk.pending.empty()) break;
+            dir_path = move(walk.pending.back());
+            walk.pending.pop_back();
+            walk.active++;
+        }
+
+        vector<string> subdirs;
+        scan_directory(dir_path, found, subdirs);
+
+        {
+            lock_guard<mutex> guard(walk.lock);
+            for (string& sub : subdirs) {
+                walk.pending.push_back(move(sub));
+            }
+            walk.active--;
+        }
+        walk.changed.notify_all();
+    }
+
+    lock_guard<mutex> guard(walk.lock);
+    walk.files.insert(walk.files.end(), found.begin(), found.end());
+}
+
+// Все файлы с заказами в дереве директорий root
+static vector<string> walk_tree(const string& root, int threads) {
+    DirectoryWalk walk;
+    walk.pending.push_back(root);
+
+    int worker_count = max(1, threads);
+    vector<thread> workers;
+    for (int t = 1; t < worker_count; t++) {
+        workers.emplace_back(walk_worker, ref(walk));
+    }
+    walk_worker(walk);
+    for (thread& w : workers) {
+        w.join();
+    }
+
+    // Потоки находят файлы вразнобой: возвращаем порядок путей
+    sort(walk.files.begin(), walk.files.end());
+    return walk.files;
+}
+
+// Раскрыть шаблон (если в нём нет * ? [, это просто путь)
+static vector<string> expand_pattern(const string& pattern) {
+    if (pattern.find_first_of("*?[") == string::npos) {
+        return vector<string>(1, pattern);
+    }
+
+    vector<string> matches;
+    glob_t result;
+    if (glob(pattern.c_str(), 0, nullptr, &result) == 0) {
+        for (size_t k = 0; k < result.gl_pathc; k++) {
+            matches.push_back(result.gl_pathv[k]);
+        }
+    }
+    globfree(&result);
+    return matches;
+}
+
+vector<string> collect_input_files(const vector<string>& inputs, int threads) {
+    vector<string> files;
+    unordered_set<string> seen;
+
+    for (const string& input : inputs) {
+        size_t matched = 0;
+
+        for (string path : expand_pattern(input)) {
+            // Лишний / в конце дал бы путь вида dir//file
+            while (path.size() > 1 && path.back() == '/') path.pop_back();
+
+            struct stat statbuf;
+            if (stat(path.c_str(), &statbuf) != 0) continue;
+
+            vector<string> found;
+            if (S_ISDIR(statbuf.st_mode)) found = walk_tree(path, threads);
+            else found.push_back(path);
+
+            matched += found.size();
+            for (string& file : found) {
+                if (seen.insert(file).second) files.push_back(move(file));
+            }
+        }
+
+        if (matched == 0) {
+            cerr << "Предупреждение: по пути " << input << " не найдено файлов с заказами" << endl;
+        }
+    }
+
+    return files;
+}
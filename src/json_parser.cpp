@@ -0,0 +1,304 @@
+#include "../include/json_parser.h"
+#include "../include/json_schema.h"
+#include <iostream>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+// Убрать пробелы в начале строки
+void skip_spaces(const string& text, int& position) {
+    while ((size_t)position < text.length() && (text[position] == ' ' ||
+                                        text[position] == '\n' || text[position] == '\t' || text[position] == '\r')) {
+        position++;
+    }
+}
+
+// Прочитать строку из JSON (в кавычках)
+string read_json_string(const string& text, int& position) {
+    skip_spaces(text, position);
+
+    // Пропускаем открывающую кавычку
+    if (text[position] != '"') {
+        cout << "Ошибка: ожидалась кавычка на позиции " << position << endl;
+        return "";
+    }
+    position++;
+
+    // Читаем символы до закрывающей кавычки
+    string result = "";
+    while ((size_t)position < text.length() && text[position] != '"') {
+        if (text[position] == '\\') {  // Обработка спецсимволов
+            position++;
+            if (text[position] == 'n') result += '\n';
+            else if (text[position] == 't') result += '\t';
+            else result += text[position];
+        }
+        else {
+            result += text[position];
+        }
+        position++;
+    }
+
+    // Пропускаем закрывающую кавычку
+    position++;
+    return result;
+}
+
+// Прочитать число из JSON
+double read_json_number(const string& text, int& position) {
+    skip_spaces(text, position);
+
+    string number_string = "";
+
+    // Минус для отрицательных чисел
+    if (text[position] == '-') {
+        number_string += text[position];
+        position++;
+    }
+
+    // Читаем цифры
+    while ((size_t)position < text.length() && (isdigit(text[position]) || text[position] == '.')) {
+        number_string += text[position];
+        position++;
+    }
+
+    // Преобразуем строку в число
+    return stod(number_string);
+}
+
+// Прочитать денежную сумму из JSON сразу в копейки (без double)
+// Третий знак после точки округляет до ближайшей копейки
+Money read_json_money(const string& text, int& position) {
+    skip_spaces(text, position);
+
+    bool negative = false;
+    if (text[position] == '-') {
+        negative = true;
+        position++;
+    }
+
+    // Целая часть (рубли)
+    Money rubles = 0;
+    while ((size_t)position < text.length() && isdigit(text[position])) {
+        rubles = rubles * 10 + (text[position] - '0');
+        position++;
+    }
+
+    // Дробная часть: две цифры копеек, третья - для округления
+    Money kopecks = 0;
+    if ((size_t)position < text.length() && text[position] == '.') {
+        position++;
+        int digits = 0;
+        while ((size_t)position < text.length() && isdigit(text[position])) {
+            if (digits < 2) {
+                kopecks = kopecks * 10 + (text[position] - '0');
+            }
+            else if (digits == 2 && text[position] >= '5') {
+                kopecks++;
+            }
+            digits++;
+            position++;
+        }
+        if (digits == 1) kopecks *= 10;
+    }
+
+    Money amount = rubles * 100 + kopecks;
+    return negative ? -amount : amount;
+}
+
+// Прочитать артикул и сразу занести в словарь. Если в строке нет
+// экранирования, артикул берётся прямо из текста без выделения памяти
+SkuId read_json_sku(const string& text, int& position) {
+    skip_spaces(text, position);
+
+    if (text[position] == '"') {
+        size_t start = position + 1;
+        size_t end = start;
+        while (end < text.length() && text[end] != '"' && text[end] != '\\') {
+            end++;
+        }
+        if (end < text.length() && text[end] == '"') {
+            position = (int)end + 1;
+            return intern_sku(string_view(text.data() + start, end - start));
+        }
+    }
+
+    return intern_sku(read_json_string(text, position));
+}
+
+// Прочитать артикул в конец sku_text (без словаря). Возвращает значение
+// для Item::sku_offset: смещение + 1, пустой артикул - 0
+static uint32_t read_json_sku_text(const string& text, int& position, string& sku_text) {
+    string sku = read_json_string(text, position);
+    if (sku.empty()) return 0;
+    uint32_t offset = (uint32_t)sku_text.size() + 1;
+    sku_text += sku;
+    sku_text += '\0';
+    return offset;
+}
+
+// Пропустить любое JSON-значение (строку, число, объект, массив, литерал)
+void skip_json_value(const string& text, int& position) {
+    skip_spaces(text, position);
+    if (position >= (int)text.length()) return;
+
+    char c = text[position];
+    if (c == '"') {
+        // Ищем закрывающую кавычку через memchr, пропуская экранированные
+        const char* begin = text.data();
+        const char* end = begin + text.length();
+        const char* p = begin + position + 1;
+        while (p < end) {
+            const char* quote = (const char*)memchr(p, '"', end - p);
+            if (quote == nullptr) {
+                p = end;
+                break;
+            }
+            // Кавычка экранирована, если перед ней нечётное число обратных слэшей
+            const char* q = quote;
+            while (q > p && q[-1] == '\\') q--;
+            p = quote + 1;
+            if ((quote - q) % 2 == 0) break;
+        }
+        position = (int)(p - begin);
+    }
+    else if (c == '{' || c == '[') {
+        // Считаем вложенность, строки внутри пропускаем целиком
+        int depth = 0;
+        while (position < (int)text.length()) {
+            char d = text[position];
+            if (d == '"') {
+                skip_json_value(text, position);
+                continue;
+            }
+            if (d == '{' || d == '[') depth++;
+            if (d == '}' || d == ']') depth--;
+            position++;
+            if (depth == 0) break;
+        }
+    }
+    else {
+        // Число или true/false/null - до разделителя
+        while (position < (int)text.length() && text[position] != ',' &&
+               text[position] != '}' && text[position] != ']') {
+            position++;
+        }
+    }
+}
+
+// ========== СХЕМЫ ТОВАРА И ЗАКАЗА ==========
+
+// Товар и строка артикулов его заказа (nullptr - артикул только в словарь)
+struct ItemTarget {
+    Item& item;
+    string* sku_text;
+};
+
+// Поля товара
+constexpr FieldDescriptor<ItemTarget> ITEM_FIELDS[] = {
+    // Артикул - номер в словаре или, без intern_skus, текст в заказе
+    {"sku", FIELD_SKU, [](const string& text, int& position, ItemTarget& target, const ParseOptions& options) {
+        if (options.intern_skus || target.sku_text == nullptr) {
+            target.item.sku = read_json_sku(text, position);
+        } else {
+            target.item.sku_offset = read_json_sku_text(text, position, *target.sku_text);
+        }
+        return true;
+    }},
+    {"qty", FIELD_QTY, [](const string& text, int& position, ItemTarget& target, const ParseOptions&) {
+        target.item.quantity = (int)read_json_number(text, position);
+        return true;
+    }},
+    {"price", FIELD_PRICE, [](const string& text, int& position, ItemTarget& target, const ParseOptions&) {
+        target.item.price = read_json_money(text, position);
+        return true;
+    }},
+};
+
+constexpr auto ITEM_SCHEMA = make_schema(ITEM_FIELDS);
+
+// Прочитать массив товаров заказа
+static bool read_json_items(const string& text, int& position, Order& order, const ParseOptions& options) {
+    skip_spaces(text, position);
+    position++; // Пропускаем [
+
+    // Читаем все товары
+    while (position < (int)text.length() && text[position] != ']') {
+        skip_spaces(text, position);
+
+        if (text[position] == ',') {
+            position++;
+            continue;
+        }
+
+        if (text[position] == ']') break;
+
+        order.items.emplace_back();
+        ItemTarget target{order.items.back(), &order.sku_text};
+        read_object(ITEM_SCHEMA, text, position, target, options);
+    }
+
+    position++; // Пропускаем ]
+    return true;
+}
+
+// Поля заказа
+constexpr FieldDescriptor<Order> ORDER_FIELDS[] = {
+    {"id", FIELD_ID, [](const string& text, int& position, Order& order, const ParseOptions&) {
+        order.id = read_json_string(text, position);
+        return true;
+    }},
+    // Период проверяется сразу после даты: товары заказа вне периода
+    // (если они идут после ts) даже не разбираются
+    {"ts", FIELD_TS, [](const string& text, int& position, Order& order, const ParseOptions& options) {
+        order.date_time = read_json_string(text, position);
+        return date_in_range(order.date_time, options);
+    }},
+    {"items", FIELDS_ITEM, read_json_items},
+};
+
+constexpr auto ORDER_SCHEMA = make_schema(ORDER_FIELDS);
+
+// ========== ЧТЕНИЕ ЗАКАЗОВ ==========
+
+Item read_json_item(const string& text, int& position, const ParseOptions& options) {
+    Item item;
+    ItemTarget target{item, nullptr};
+    read_object(ITEM_SCHEMA, text, position, target, options);
+    return item;
+}
+
+Order read_json_order(const string& text, int& position, const ParseOptions& options) {
+    Order order;
+    read_object(ORDER_SCHEMA, text, position, order, options);
+    return order;
+}
+
+vector<Order> read_json(const string& text, const ParseOptions& options) {
+    vector<Order> orders;
+    int position = 0;
+
+    skip_spaces(text, position);
+    position++; // Пропускаем [
+
+    // Читаем все заказы
+    while ((size_t)position < text.length() && text[position] != ']') {
+        skip_spaces(text, position);
+
+        if (text[position] == ',') {
+            position++;
+            continue;
+        }
+
+        if (text[position] == ']') break;
+
+        // Заказ вне периода --from/--to не попадает в результат
+        orders.emplace_back();
+        if (!read_object(ORDER_SCHEMA, text, position, orders.back(), options)) {
+            orders.pop_back();
+        }
+    }
+
+    return orders;
+}
@@ -0,0 +1,335 @@
+#include "../include/load_pipeline.h"
+#include "../include/bounded_queue.h"
+#include "../include/json_parser.h"
+#include "../include/uring_reader.h"
+#include "../include/gzip_reader.h"
+#include "../include/segment_store.h"
+#include <iostream>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+// Содержимое одного файла (index - номер в списке путей)
+struct FileContents {
+    size_t index = 0;
+    string text;
+};
+
+// Заказы одного файла
+struct ParsedFile {
+    size_t index = 0;
+    vector<Order> orders;
+};
+
+// Сколько файлов в работе: чтение берёт место, расчёт возвращает
+struct BufferPool {
+    size_t capacity;
+    size_t delivered = 0;       // Файлов уже учтено расчётом
+    size_t peak = 0;
+    mutex lock;
+    condition_variable released;
+
+    explicit BufferPool(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    // Дождаться места под файл index (файлы берутся по порядку)
+    void acquire(size_t index, long long& wait_us) {
+        unique_lock<mutex> guard(lock);
+        if (index >= delivered + capacity) {
+            auto start = chrono::steady_clock::now();
+            released.wait(guard, [&]() { return index < delivered + capacity; });
+            wait_us += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        }
+        peak = max(peak, index + 1 - delivered);
+    }
+
+    void release_until(size_t count) {
+        {
+            lock_guard<mutex> guard(lock);
+            delivered = count;
+        }
+        released.notify_one();
+    }
+};
+
+static long long elapsed_us(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+}
+
+// Прочитать файл целиком (пустая строка, если не открылся)
+static string read_file_text(const string& path) {
+    string text;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        cerr << "Предупреждение: не могу открыть файл " << path << endl;
+        return text;
+    }
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, n);
+    }
+    fclose(file);
+    return text;
+}
+
+// Проверить пачку заказов (без keep_orders): счётчики складываются,
+// заказы из образца ошибок сохраняются под сквозными номерами
+static void validate_batch(const vector<Order>& orders, size_t first_index, const ValidationOptions& options,
+                           LoadResult& result) {
+    ValidationResult& total = result.validation;
+    if (total.stopped_early) return;
+
+    ValidationOptions batch_options = options;
+    batch_options.threads = 1;
+    if (options.max_errors > 0) batch_options.max_errors = options.max_errors - total.total;
+    ValidationResult batch = validate_orders(orders, batch_options);
+
+    for (int k = 0; k < ERR_CODE_COUNT; k++) {
+        total.counts[k] += batch.counts[k];
+    }
+    total.total += batch.total;
+    total.stopped_early = batch.stopped_early;
+    for (ValidationError e : batch.sample) {
+        if (total.sample.size() >= options.sample_size) break;
+        result.error_orders.emplace(first_index + e.order_index, orders[e.order_index]);
+        e.order_index += first_index;
+        total.sample.push_back(e);
+    }
+}
+
+LoadResult load_files(const vector<string>& paths, const LoadOptions& options) {
+    LoadResult result;
+    auto wall_start = chrono::steady_clock::now();
+
+    size_t buffers = max<size_t>(1, options.buffers);
+    int parser_count = max(1, options.parser_threads);
+
+    BufferPool pool(buffers);
+    BoundedQueue<FileContents> files(buffers);
+    BoundedQueue<ParsedFile> parsed(buffers);
+
+    StageStats reader;
+    reader.name = "Чтение";
+    vector<StageStats> parsers(parser_count);
+    vector<StageStats> unpackers(parser_count);   // Распаковка .gz (в тех же потоках)
+    StageStats aggregator;
+    aggregator.name = "Расчёт";
+
+    // Стадия чтения: файлы по порядку, каждый сначала занимает место в пуле
+    thread reader_thread([&]() {
+        auto start = chrono::steady_clock::now();
+        auto put = [&](size_t index, string& text) {
+            FileContents file;
+            file.index = index;
+            file.text = move(text);
+            files.push(move(file), reader.wait_output_us);
+            reader.items++;
+        };
+
+        size_t delivered = 0;
+        if (options.use_uring) {
+            // Место занимается до отправки в очередь: io_uring читает с опережением
+            // не больше своего окна, а дальше ждёт вместе с нами
+            bool started = uring_read_files(paths, min(buffers, URING_QUEUE_DEPTH), [&](size_t index, string& text) {
+                pool.acquire(index, reader.wait_output_us);
+                put(index, text);
+            }, delivered);
+            if (!started && options.show_progress) {
+                cout << "  io_uring недоступен, обычное чтение файлов" << endl;
+            }
+        }
+
+        // Обычное чтение - всё или то, что io_uring не успел отдать
+        // (отданные файлы уже в очереди, второй раз их не кладём)
+        for (size_t i = delivered; i < paths.size(); i++) {
+            pool.acquire(i, reader.wait_output_us);
+            string text = read_file_text(paths[i]);
+            put(i, text);
+        }
+
+        files.close();
+        reader.busy_us = elapsed_us(start) - reader.wait_output_us;
+    });
+
+    // Стадия разбора: любой свободный поток берёт следующий файл
+    vector<thread> parser_threads;
+    for (int t = 0; t < parser_count; t++) {
+        parser_threads.emplace_back([&, t]() {
+            StageStats& stats = parsers[t];
+            StageStats& unpack = unpackers[t];
+            FileContents file;
+            while (files.pop(file, stats.wait_input_us)) {
+                // Сжатый файл распаковывается тем же потоком прямо перед
+                // разбором: распаковка одних файлов идёт параллельно
+                // с чтением и разбором других
+                if (is_gzip(file.text)) {
+                    auto unpack_start = chrono::steady_clock::now();
+                    string text;
+                    if (!gunzip(file.text, text)) {
+                        cerr << "Предупреждение: повреждён сжатый файл " << paths[file.index] << endl;
+                        text.clear();
+                    }
+                    file.text = move(text);
+                    unpack.busy_us += elapsed_us(unpack_start);
+                    unpack.items++;
+                }
+
+                auto start = chrono::steady_clock::now();
+                ParsedFile batch;
+                batch.index = file.index;
+                batch.orders = is_segment(file.text) ? read_segment(file.text, options.parse)
+                                                     : read_json(file.text, options.parse);
+                file.text = string();
+                stats.busy_us += elapsed_us(start);
+                stats.items++;
+                parsed.push(move(batch), stats.wait_output_us);
+            }
+        });
+    }
+
+    // Когда все файлы разобраны, закрываем очередь расчёта
+    thread closer([&]() {
+        for (thread& p : parser_threads) {
+            p.join();
+        }
+        parsed.close();
+    });
+
+    // Стадия расчёта (в этом потоке): пачки приходят вразнобой,
+    // а учитываются строго по порядку файлов
+    AnalyticsAccumulator acc = make_accumulator(options.metrics, options.approx_capacity, options.memory_limit,
+                                                options.top_count);
+    bool need_id = (options.parse.fields & FIELD_ID) != 0;
+
+    // Повторы по ходу загрузки: заказы идут по порядку файлов,
+    // поэтому первое вхождение встречается первым
+    const DedupOptions& dedup = options.dedup;
+    bool dedup_stream = dedup_streams(dedup);
+    OrderIdSet seen;
+    map<size_t, vector<Order>> pending;
+    size_t next = 0;
+    size_t total = paths.size();
+
+    // Без keep_orders заказы пачки живут только до её учёта
+    // (повторы, которые не ищутся по ходу, требуют всех заказов)
+    bool keep_orders = options.keep_orders || (dedup.mode != DEDUP_OFF && !dedup_stream);
+    vector<Order> batch_orders;
+    vector<Order>& kept = keep_orders ? result.orders : batch_orders;
+
+    ParsedFile batch;
+    while (parsed.pop(batch, aggregator.wait_input_us)) {
+        auto start = chrono::steady_clock::now();
+        pending[batch.index] = move(batch.orders);
+
+        auto it = pending.begin();
+        while (it != pending.end() && it->first == next) {
+            // Заказы без ID пропускаем (только если ID читался)
+            size_t first = kept.size();
+            for (Order& order : it->second) {
+                if (need_id && order.id.empty()) continue;
+                if (dedup_stream) {
+                    result.dedup.checked++;
+                    if (!seen.insert(order.id)) {
+                        result.dedup.duplicates++;
+                        if (result.dedup.examples.size() < DEDUP_EXAMPLES) {
+                            result.dedup.examples.push_back(order.id);
+                        }
+                        if (dedup.mode == DEDUP_FIRST) {
+                            result.dedup.removed++;
+                            continue;
+                        }
+                    }
+                }
+                kept.push_back(move(order));
+            }
+            accumulate_orders(acc, kept, first, kept.size());
+            size_t added = kept.size() - first;
+            if (!keep_orders) {
+                validate_batch(batch_orders, result.order_count, options.validation, result);
+                batch_orders.clear();
+            }
+            result.order_count += added;
+
+            it = pending.erase(it);
+            next++;
+            aggregator.items++;
+
+            // Показываем прогресс для больших директорий
+            if (options.show_progress && total >= 100 && next % (total / 10) == 0) {
+                cout << "  Прочитано файлов: " << next << "/" << total
+                     << " (" << (next * 100 / total) << "%)" << endl;
+            }
+        }
+        pool.release_until(next);
+        aggregator.busy_us += elapsed_us(start);
+    }
+
+    reader_thread.join();
+    closer.join();
+
+    result.analytics = finish_accumulator(acc);
+    if (dedup_stream) {
+        result.dedup.memory_bytes = seen.memory_bytes();
+    }
+    else if (dedup.mode != DEDUP_OFF) {
+        result.dedup = deduplicate_orders(result.orders, dedup);
+        if (result.dedup.removed > 0) {
+            result.analytics = aggregate_orders(result.orders, parser_count, options.metrics, options.approx_capacity,
+                                                options.memory_limit, options.top_count);
+        }
+        result.order_count = result.orders.size();
+    }
+    result.wall_us = elapsed_us(wall_start);
+    result.peak_buffers = pool.peak;
+
+    // Потоки разбора показываем одной стадией
+    StageStats parser;
+    parser.name = "Разбор";
+    parser.workers = parser_count;
+    for (const StageStats& s : parsers) {
+        parser.busy_us += s.busy_us;
+        parser.wait_input_us += s.wait_input_us;
+        parser.wait_output_us += s.wait_output_us;
+        parser.items += s.items;
+    }
+
+    StageStats unpack;
+    unpack.name = "Распаковка";
+    unpack.workers = parser_count;
+    for (const StageStats& s : unpackers) {
+        unpack.busy_us += s.busy_us;
+        unpack.items += s.items;
+    }
+
+    result.stages.push_back(reader);
+    if (unpack.items > 0) result.stages.push_back(unpack);
+    result.stages.push_back(parser);
+    result.stages.push_back(aggregator);
+    return result;
+}
+
+void print_load_stats(const LoadResult& result) {
+    string text;
+    char line[160];
+
+    text += "Стадия     Потоков   Работа     Ждали вход  Ждали выход  Занятость\n";
+    text += "-------------------------------------------------------------------\n";
+    for (const StageStats& s : result.stages) {
+        double capacity = (double)result.wall_us * s.workers;
+        double utilization = capacity > 0 ? 100.0 * s.busy_us / capacity : 0;
+        // Название с кириллицей: ширину добиваем по символам, а не байтам
+        string name = s.name + string(s.name.size() / 2 < 11 ? 11 - s.name.size() / 2 : 1, ' ');
+        snprintf(line, sizeof(line), "%7d   %6lld мс  %7lld мс  %8lld мс  %7.1f%%\n",
+                 s.workers, s.busy_us / 1000, s.wait_input_us / 1000, s.wait_output_us / 1000, utilization);
+        text += name;
+        text += line;
+    }
+    text += "Файлов в работе (пик): " + to_string(result.peak_buffers) + "\n";
+    cout << text;
+}
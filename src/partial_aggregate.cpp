@@ -0,0 +1,264 @@
+#include "../include/partial_aggregate.h"
+#include "../include/varint.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+using namespace std;
+
+vector<string> select_shard(const vector<string>& files, int index, int count) {
+    if (count <= 1) return files;
+
+    vector<string> selected;
+    for (const string& path : files) {
+        size_t slash = path.find_last_of('/');
+        string_view name = slash == string::npos ? string_view(path) : string_view(path).substr(slash + 1);
+        if ((int)(distinct_hash(name) % count) == index - 1) {
+            selected.push_back(path);
+        }
+    }
+    return selected;
+}
+
+// ---------- Запись ----------
+
+static void put_string(string& out, const string& text) {
+    put_varint(out, text.size());
+    out += text;
+}
+
+static void put_hll(string& out, const HyperLogLog& hll) {
+    put_varint(out, hll.registers.empty() ? 0 : hll.precision);
+    out.append((const char*)hll.registers.data(), hll.registers.size());
+}
+
+bool write_partial(const string& path, const AnalyticsPart& part, const PartialInfo& info) {
+    string out(PARTIAL_MAGIC, sizeof(PARTIAL_MAGIC));
+    put_varint(out, PARTIAL_VERSION);
+
+    put_varint(out, info.shard_index);
+    put_varint(out, info.shard_count);
+    put_varint(out, info.file_count);
+    put_varint(out, info.metrics);
+    put_string(out, info.date_from);
+    put_string(out, info.date_to);
+    put_varint(out, info.orders_checked);
+    put_varint(out, ERR_CODE_COUNT);
+    for (int k = 0; k < ERR_CODE_COUNT; k++) put_varint(out, info.error_counts[k]);
+    put_varint(out, info.error_total);
+    put_varint(out, info.duplicates_removed);
+
+    put_varint(out, part.order_count);
+    put_varint(out, part.item_count);
+    put_varint(out, zigzag(part.total_revenue));
+
+    put_varint(out, part.daily_revenue.size());
+    for (const auto& p : part.daily_revenue) {
+        put_string(out, p.first);
+        put_varint(out, zigzag(p.second));
+    }
+
+    // Только встречавшиеся артикулы (с лимитом памяти они уже разрежены)
+    if (!part.product_totals.empty()) {
+        put_varint(out, part.product_totals.size());
+        for (const SkuTotal& t : part.product_totals) {
+            put_string(out, sku_name(t.sku));
+            put_varint(out, zigzag(t.revenue));
+            put_varint(out, t.lines);
+        }
+    } else {
+        size_t sku_total = 0;
+        for (uint32_t lines : part.product_lines) sku_total += lines > 0;
+        put_varint(out, sku_total);
+        for (size_t k = 0; k < part.product_lines.size(); k++) {
+            if (part.product_lines[k] == 0) continue;
+            put_string(out, sku_name((SkuId)k));
+            put_varint(out, zigzag(part.product_revenue[k]));
+            put_varint(out, part.product_lines[k]);
+        }
+    }
+
+    put_varint(out, part.order_value_histogram.size());
+    for (long long count : part.order_value_histogram) put_varint(out, count);
+
+    const QuantileSketch& sketch = part.order_value_sketch;
+    put_varint(out, sketch.count);
+    put_varint(out, sketch.zero_count);
+    put_varint(out, zigzag(sketch.min_key));
+    put_varint(out, sketch.buckets.size());
+    for (long long count : sketch.buckets) put_varint(out, count);
+
+    put_hll(out, part.distinct_orders);
+    put_hll(out, part.distinct_skus);
+    put_varint(out, part.daily_distinct_skus.size());
+    for (const auto& p : part.daily_distinct_skus) {
+        put_string(out, p.first);
+        put_hll(out, p.second);
+    }
+
+    put_varint(out, part.approx_capacity);
+    put_varint(out, part.approx_top.size());
+    for (const ApproxCounter& c : part.approx_top) {
+        put_string(out, c.sku);
+        put_varint(out, zigzag(c.count));
+        put_varint(out, zigzag(c.error));
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        cerr << "Ошибка: не могу создать файл " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        cerr << "Ошибка: не удалось записать " << path << endl;
+    }
+    return ok;
+}
+
+// ---------- Чтение ----------
+
+// Позиция чтения: при выходе за конец ok сбрасывается, дальше читаются нули
+struct PartialCursor {
+    const unsigned char* p;
+    const unsigned char* end;
+    bool ok = true;
+
+    uint64_t number() {
+        uint64_t value = 0;
+        if (ok && !get_varint(p, end, value)) ok = false;
+        return ok ? value : 0;
+    }
+
+    long long signed_number() {
+        return unzigzag(number());
+    }
+
+    string text() {
+        uint64_t length = number();
+        if (!ok || length > (uint64_t)(end - p)) {
+            ok = false;
+            return string();
+        }
+        string value((const char*)p, length);
+        p += length;
+        return value;
+    }
+
+    void read_hll(HyperLogLog& hll) {
+        int precision = (int)number();
+        if (precision == 0) return;
+        size_t size = (size_t)1 << precision;
+        if (precision > 20 || size > (size_t)(end - p)) {
+            ok = false;
+            return;
+        }
+        hll.precision = precision;
+        hll.registers.assign(p, p + size);
+        p += size;
+    }
+};
+
+bool read_partial(const string& path, AnalyticsPart& part, PartialInfo& info) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        cerr << "Ошибка: не могу открыть файл " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    string data;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.append(chunk, n);
+    }
+    fclose(file);
+
+    if (data.size() < sizeof(PARTIAL_MAGIC) || memcmp(data.data(), PARTIAL_MAGIC, sizeof(PARTIAL_MAGIC)) != 0) {
+        cerr << "Ошибка: " << path << " - не файл частичных итогов" << endl;
+        return false;
+    }
+
+    PartialCursor in;
+    in.p = (const unsigned char*)data.data() + sizeof(PARTIAL_MAGIC);
+    in.end = (const unsigned char*)data.data() + data.size();
+    if (in.number() != PARTIAL_VERSION) {
+        cerr << "Ошибка: " << path << " - неподдерживаемая версия файла" << endl;
+        return false;
+    }
+
+    info.shard_index = (int)in.number();
+    info.shard_count = (int)in.number();
+    info.file_count = in.number();
+    info.metrics = (unsigned)in.number();
+    info.date_from = in.text();
+    info.date_to = in.text();
+    info.orders_checked = in.number();
+    uint64_t codes = in.number();
+    for (uint64_t k = 0; k < codes && in.ok; k++) {
+        long long count = in.number();
+        if (k < ERR_CODE_COUNT) info.error_counts[k] = count;
+    }
+    info.error_total = in.number();
+    info.duplicates_removed = in.number();
+
+    part.order_count = in.number();
+    part.item_count = in.number();
+    part.total_revenue = in.signed_number();
+
+    uint64_t days = in.number();
+    for (uint64_t k = 0; k < days && in.ok; k++) {
+        string date = in.text();
+        part.daily_revenue[date] += in.signed_number();
+    }
+
+    uint64_t skus = in.number();
+    for (uint64_t k = 0; k < skus && in.ok; k++) {
+        SkuId sku = intern_sku(in.text());
+        if (sku >= part.product_revenue.size()) {
+            part.product_revenue.resize(sku_count(), 0);
+            part.product_lines.resize(sku_count(), 0);
+        }
+        part.product_revenue[sku] += in.signed_number();
+        part.product_lines[sku] += (uint32_t)in.number();
+    }
+
+    uint64_t buckets = in.number();
+    for (uint64_t k = 0; k < buckets && in.ok; k++) {
+        part.order_value_histogram.push_back(in.number());
+    }
+
+    QuantileSketch& sketch = part.order_value_sketch;
+    sketch.count = in.number();
+    sketch.zero_count = in.number();
+    sketch.min_key = (int)in.signed_number();
+    uint64_t sketch_buckets = in.number();
+    for (uint64_t k = 0; k < sketch_buckets && in.ok; k++) {
+        sketch.buckets.push_back(in.number());
+    }
+
+    in.read_hll(part.distinct_orders);
+    in.read_hll(part.distinct_skus);
+    uint64_t hll_days = in.number();
+    for (uint64_t k = 0; k < hll_days && in.ok; k++) {
+        string date = in.text();
+        in.read_hll(part.daily_distinct_skus[date]);
+    }
+
+    part.approx_capacity = in.number();
+    uint64_t counters = in.number();
+    for (uint64_t k = 0; k < counters && in.ok; k++) {
+        ApproxCounter c;
+        c.sku = in.text();
+        c.count = in.signed_number();
+        c.error = in.signed_number();
+        part.approx_top.push_back(c);
+    }
+
+    if (!in.ok) {
+        cerr << "Ошибка: файл " << path << " повреждён или обрезан" << endl;
+        return false;
+    }
+    return true;
+}
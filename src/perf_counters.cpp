@@ -0,0 +1,173 @@
+#include "../include/perf_counters.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+// Открыть один счётчик для текущего потока на любом CPU
+static int open_counter(uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;          // Учитываем и рабочие потоки
+    attr.exclude_kernel = 1;   // Работает при perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+bool perf_open(PerfCounters& counters) {
+    counters.open_errno = 0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        counters.fd[i] = -1;
+    }
+
+#ifdef __linux__
+    const uint64_t configs[PERF_EVENT_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        counters.fd[i] = open_counter(configs[i]);
+        if (counters.fd[i] < 0 && counters.open_errno == 0) {
+            counters.open_errno = errno;
+        }
+    }
+#else
+    counters.open_errno = ENOSYS;
+#endif
+
+    return perf_available(counters);
+}
+
+void perf_close(PerfCounters& counters) {
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (counters.fd[i] >= 0) {
+            close(counters.fd[i]);
+        }
+        counters.fd[i] = -1;
+    }
+#endif
+}
+
+bool perf_available(const PerfCounters& counters) {
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (counters.fd[i] >= 0) return true;
+    }
+    return false;
+}
+
+void perf_start(PerfCounters& counters) {
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (counters.fd[i] < 0) continue;
+        ioctl(counters.fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters.fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+PerfSample perf_stop(PerfCounters& counters) {
+    PerfSample sample;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        sample.valid[i] = false;
+        sample.value[i] = 0;
+    }
+
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (counters.fd[i] < 0) continue;
+        ioctl(counters.fd[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        // value, time_enabled, time_running
+        uint64_t data[3] = {0, 0, 0};
+        if (read(counters.fd[i], data, sizeof(data)) != (ssize_t)sizeof(data)) continue;
+        if (data[2] == 0) continue;  // Счётчик так и не попал на PMU
+
+        // Если счётчики мультиплексировались, масштабируем значение
+        double scale = (double)data[1] / (double)data[2];
+        sample.value[i] = (long long)(data[0] * scale);
+        sample.valid[i] = true;
+    }
+#endif
+
+    return sample;
+}
+
+void print_perf_sample(const string& phase, const PerfSample& sample, size_t orders) {
+    cout << "  [perf] " << phase << ":";
+
+    bool any = false;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (sample.valid[i]) any = true;
+    }
+    if (!any) {
+        cout << " нет данных" << endl;
+        return;
+    }
+
+    cout.precision(2);
+    cout << fixed;
+
+    if (sample.valid[PERF_CYCLES]) {
+        cout << " циклы " << sample.value[PERF_CYCLES];
+    }
+    if (sample.valid[PERF_INSTRUCTIONS]) {
+        cout << " инструкции " << sample.value[PERF_INSTRUCTIONS];
+    }
+    if (sample.valid[PERF_CYCLES] && sample.valid[PERF_INSTRUCTIONS] && sample.value[PERF_CYCLES] > 0) {
+        cout << " IPC " << (double)sample.value[PERF_INSTRUCTIONS] / sample.value[PERF_CYCLES];
+    }
+    cout << endl;
+
+    if (orders == 0) return;
+
+    if (!sample.valid[PERF_CACHE_MISSES] && !sample.valid[PERF_BRANCH_MISSES]) return;
+
+    cout << "         ";
+    if (sample.valid[PERF_CACHE_MISSES]) {
+        cout << " промахи кэша на заказ " << (double)sample.value[PERF_CACHE_MISSES] / orders;
+    }
+    if (sample.valid[PERF_BRANCH_MISSES]) {
+        cout << " промахи ветвлений на заказ " << (double)sample.value[PERF_BRANCH_MISSES] / orders;
+    }
+    cout << endl;
+}
+
+void print_perf_unavailable(const PerfCounters& counters) {
+    cout << "Предупреждение: аппаратные счётчики недоступны ("
+         << strerror(counters.open_errno) << ")" << endl;
+
+#ifdef __linux__
+    ifstream paranoid("/proc/sys/kernel/perf_event_paranoid");
+    int level = 0;
+    if (paranoid >> level) {
+        cout << "  kernel.perf_event_paranoid = " << level;
+        if (level > 2) {
+            cout << " (нужно <= 2)";
+        }
+        cout << endl;
+    }
+#endif
+    cout << "  Замеры продолжатся только по времени." << endl;
+}
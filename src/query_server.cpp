@@ -0,0 +1,251 @@
+#include "../include/query_server.h"
+#include "../include/session.h"
+#include "../include/report_writer.h"
+#include "../include/bounded_queue.h"
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Флаг остановки (ставится обработчиком сигнала)
+static volatile sig_atomic_t server_stop = 0;
+
+static void server_signal(int) {
+    server_stop = 1;
+}
+
+// Общее состояние сервера: данные только читаются, кэш - под блокировкой
+struct QueryServer {
+    SessionData data;
+    int top_count = 5;
+    ParseOptions parse;     // Период --from/--to (для отчёта)
+
+    unordered_map<string, string> cache;    // запрос -> готовый ответ
+    shared_mutex cache_lock;
+
+    atomic<long long> requests{0};
+    atomic<long long> cache_hits{0};
+    atomic<long long> connections{0};
+};
+
+// Ответ на запрос (без кэша). false - ошибка, текст ошибки в answer
+static bool server_answer(const QueryServer& server, const string& command, istringstream& words, string& answer) {
+    if (command == "ping") {
+        answer = "pong\n";
+    }
+    else if (command == "report") {
+        string name = "text";
+        words >> name;
+        OutputFormat format;
+        if (!parse_output_format(name, format)) {
+            answer = "неизвестный формат " + name;
+            return false;
+        }
+        ReportData report = make_report_data(server.data.stats, REPORTS_DEFAULT, server.top_count);
+        report.date_from = server.parse.date_from;
+        report.date_to = server.parse.date_to;
+        ReportWriter writer;    // Без файла: текст остаётся в буфере
+        write_report(writer, report, format);
+        answer = move(writer.buffer);
+    }
+    else if (command == "summary") {
+        answer = answer_stats(server.data);
+    }
+    else if (command == "daily") {
+        string from, to;
+        words >> from >> to;
+        answer = answer_daily(server.data, from, to);
+    }
+    else if (command == "top") {
+        int n = server.top_count;
+        words >> n;
+        answer = answer_top(server.data, n);
+    }
+    else if (command == "sku") {
+        string sku;
+        if (!(words >> sku)) {
+            answer = "нужен артикул: sku АРТИКУЛ";
+            return false;
+        }
+        answer = answer_sku(server.data, sku);
+    }
+    else {
+        answer = "неизвестный запрос " + command;
+        return false;
+    }
+    return true;
+}
+
+// Обработать одну строку запроса и вернуть ответ целиком (с заголовком)
+static string server_handle(QueryServer& server, const string& line) {
+    server.requests++;
+
+    // Ключ кэша - слова запроса через один пробел
+    istringstream words(line);
+    string key, word;
+    while (words >> word) {
+        if (!key.empty()) key += ' ';
+        key += word;
+    }
+    if (key.empty()) return "ERR пустой запрос\n";
+
+    {
+        shared_lock<shared_mutex> read_lock(server.cache_lock);
+        auto it = server.cache.find(key);
+        if (it != server.cache.end()) {
+            server.cache_hits++;
+            return it->second;
+        }
+    }
+
+    istringstream request(key);
+    string command;
+    request >> command;
+    string answer;
+    if (!server_answer(server, command, request, answer)) {
+        return "ERR " + answer + "\n";
+    }
+
+    string response = "OK " + to_string(answer.size()) + "\n" + answer;
+    unique_lock<shared_mutex> write_lock(server.cache_lock);
+    if (server.cache.size() < SERVER_CACHE_LIMIT) {
+        server.cache.emplace(key, response);
+    }
+    return response;
+}
+
+static bool send_all(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// Обслужить одно соединение: строки запросов до закрытия или остановки
+static void serve_client(QueryServer& server, int fd) {
+    server.connections++;
+    string pending;
+    char chunk[4096];
+
+    while (!server_stop) {
+        // Ждём данные порциями, чтобы вовремя заметить остановку
+        pollfd waiting = {fd, POLLIN, 0};
+        int ready = poll(&waiting, 1, 200);
+        if (ready < 0 && errno != EINTR) break;
+        if (ready <= 0) continue;
+
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(chunk, n);
+
+        size_t end;
+        bool ok = true;
+        while (ok && (end = pending.find('\n')) != string::npos) {
+            string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            ok = send_all(fd, line.size() > SERVER_MAX_LINE ? string("ERR слишком длинный запрос\n")
+                                                             : server_handle(server, line));
+        }
+        if (!ok) break;
+
+        // Строка без конца длиннее предела: дальше её не копим
+        if (pending.size() > SERVER_MAX_LINE) {
+            send_all(fd, "ERR слишком длинный запрос\n");
+            break;
+        }
+    }
+    close(fd);
+}
+
+int run_server(const string& socket_path, const vector<string>& inputs, const LoadOptions& options,
+               int workers, int top_count) {
+    QueryServer server;
+    server.top_count = top_count;
+    server.parse = options.parse;
+
+    cout << "Загрузка из ";
+    for (size_t k = 0; k < inputs.size(); k++) cout << (k > 0 ? ", " : "") << inputs[k];
+    cout << "..." << endl;
+    SessionLog log;
+    if (!session_load(server.data, inputs, options, log)) {
+        return 1;
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        cerr << "Ошибка: слишком длинный путь к сокету " << socket_path << endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        cerr << "Ошибка: не могу открыть сокет " << socket_path << ": " << strerror(errno) << endl;
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+
+    signal(SIGINT, server_signal);
+    signal(SIGTERM, server_signal);
+
+    // Пул: принятые соединения ждут свободный поток в очереди
+    int worker_count = max(1, workers);
+    BoundedQueue<int> clients(worker_count * 4);
+    vector<thread> pool;
+    for (int t = 0; t < worker_count; t++) {
+        pool.emplace_back([&server, &clients]() {
+            long long waited = 0;
+            int fd;
+            while (clients.pop(fd, waited)) {
+                serve_client(server, fd);
+            }
+        });
+    }
+
+    cout << "Сервер слушает " << socket_path << " (потоков: " << worker_count << "), остановка - Ctrl+C" << endl;
+
+    long long waited = 0;
+    while (!server_stop) {
+        pollfd waiting = {listener, POLLIN, 0};
+        int ready = poll(&waiting, 1, 200);
+        if (ready <= 0) continue;
+
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        if (!clients.push(move(fd), waited)) {
+            close(fd);
+        }
+    }
+
+    clients.close();
+    for (thread& t : pool) {
+        t.join();
+    }
+    close(listener);
+    unlink(socket_path.c_str());
+
+    cout << endl << "Сервер остановлен. Соединений: " << server.connections << ", запросов: " << server.requests
+         << ", из кэша: " << server.cache_hits << endl;
+    return 0;
+}
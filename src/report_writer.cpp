@@ -0,0 +1,373 @@
+#include "../include/report_writer.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+using namespace std;
+
+bool report_open(ReportWriter& writer, const string& path) {
+    writer.buffer.clear();
+    writer.buffer.reserve(REPORT_BUFFER_SIZE);
+
+    if (path.empty()) {
+        writer.file = stdout;
+        writer.owns_file = false;
+        return true;
+    }
+
+    writer.file = fopen(path.c_str(), "wb");
+    writer.owns_file = writer.file != nullptr;
+    if (writer.file == nullptr) {
+        cerr << "Ошибка: не могу создать файл " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
+
+void report_append(ReportWriter& writer, const string& text) {
+    writer.buffer += text;
+    if (writer.buffer.size() >= REPORT_BUFFER_SIZE) {
+        report_flush(writer);
+    }
+}
+
+void report_flush(ReportWriter& writer) {
+    if (writer.file == nullptr || writer.buffer.empty()) return;
+
+    // В stdout пишет и cout: сначала выталкиваем его, чтобы не перепутать порядок
+    if (writer.file == stdout) {
+        cout.flush();
+    }
+    fwrite(writer.buffer.data(), 1, writer.buffer.size(), writer.file);
+    fflush(writer.file);
+    writer.buffer.clear();
+}
+
+void report_close(ReportWriter& writer) {
+    report_flush(writer);
+    if (writer.owns_file) {
+        fclose(writer.file);
+    }
+    writer.file = nullptr;
+    writer.owns_file = false;
+}
+
+bool parse_output_format(const string& name, OutputFormat& format) {
+    if (name == "text") format = OUTPUT_TEXT;
+    else if (name == "json") format = OUTPUT_JSON;
+    else if (name == "csv") format = OUTPUT_CSV;
+    else return false;
+    return true;
+}
+
+string format_money(Money amount) {
+    string result;
+    if (amount < 0) {
+        result += '-';
+        amount = -amount;
+    }
+    Money kopecks = amount % 100;
+    result += to_string(amount / 100);
+    result += '.';
+    result += (char)('0' + kopecks / 10);
+    result += (char)('0' + kopecks % 10);
+    return result;
+}
+
+string format_line(int length) {
+    return string(length, '=') + "\n";
+}
+
+string format_header(const string& text) {
+    string result = "\n";
+    result += format_line(70);
+    result += "  ";
+    result += text;
+    result += "\n";
+    result += format_line(70);
+    result += "\n";
+    return result;
+}
+
+// Экранировать строку для JSON
+static string json_string(const string& text) {
+    string result = "\"";
+    for (char c : text) {
+        if (c == '"') result += "\\\"";
+        else if (c == '\\') result += "\\\\";
+        else if (c == '\n') result += "\\n";
+        else if (c == '\t') result += "\\t";
+        else if ((unsigned char)c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+            result += code;
+        }
+        else result += c;
+    }
+    return result + "\"";
+}
+
+// Экранировать поле CSV (кавычки, если есть запятая, кавычка или перевод строки)
+static string csv_field(const string& text) {
+    if (text.find_first_of(",\"\n") == string::npos) return text;
+    string result = "\"";
+    for (char c : text) {
+        if (c == '"') result += '"';
+        result += c;
+    }
+    return result + "\"";
+}
+
+// Подпись корзины гистограммы
+static string bucket_label(int k) {
+    if (k == 0) return "до " + format_money(ORDER_VALUE_BOUNDS[0]);
+    if (k == ORDER_VALUE_BUCKETS - 1) return "от " + format_money(ORDER_VALUE_BOUNDS[k - 1]);
+    return format_money(ORDER_VALUE_BOUNDS[k - 1]) + " - " + format_money(ORDER_VALUE_BOUNDS[k]);
+}
+
+// Текстовые таблицы (прежний консольный вид)
+static void write_text(ReportWriter& w, const ReportData& data) {
+    if (data.sections & REPORT_SUMMARY) {
+        report_append(w, format_header("ОБЩАЯ СТАТИСТИКА"));
+        if (!data.date_from.empty() || !data.date_to.empty()) {
+            report_append(w, "Период:               " + (data.date_from.empty() ? string("...") : data.date_from) +
+                             " - " + (data.date_to.empty() ? string("...") : data.date_to) + "\n");
+        }
+        report_append(w, "Всего заказов:        " + to_string(data.order_count) + "\n");
+        report_append(w, "Общая выручка:        " + format_money(data.total_revenue) + " руб.\n");
+        report_append(w, "Средний чек:          " + format_money(data.average_check) + " руб.\n");
+        for (const auto& p : data.check_percentiles) {
+            // "Чек" - три двухбайтовых символа, выравниваем по экранной ширине
+            string label = "Чек p" + to_string(p.first) + ":";
+            report_append(w, label + string(25 - label.size(), ' ') + format_money(p.second) + " руб.\n");
+        }
+        report_append(w, "Всего товаров:        " + to_string(data.item_count) + "\n");
+        if (data.has_distinct) {
+            report_append(w, "Разных заказов:       " + to_string(data.distinct_orders) + " (оценка)\n");
+            report_append(w, "Разных артикулов:     " + to_string(data.distinct_skus) + " (оценка)\n");
+            if (!data.daily_distinct_skus.empty()) {
+                long long sum = 0;
+                auto busiest = data.daily_distinct_skus.begin();
+                for (auto it = data.daily_distinct_skus.begin(); it != data.daily_distinct_skus.end(); ++it) {
+                    sum += it->second;
+                    if (it->second > busiest->second) busiest = it;
+                }
+                report_append(w, "Артикулов за день:    в среднем " +
+                                 to_string(sum / (long long)data.daily_distinct_skus.size()) + ", максимум " +
+                                 to_string(busiest->second) + " (" + busiest->first + ")\n");
+            }
+        }
+        report_append(w, "\n");
+    }
+
+    if (data.sections & REPORT_DAILY) {
+        report_append(w, format_header("ВЫРУЧКА ПО ДНЯМ"));
+        report_append(w, "Дата            Выручка\n");
+        report_append(w, "--------------------------------\n");
+        for (const auto& p : data.daily_revenue) {
+            report_append(w, p.first + "      " + format_money(p.second) + " руб.\n");
+        }
+        report_append(w, "\n");
+    }
+
+    if (data.sections & REPORT_TOP) {
+        report_append(w, format_header("ТОП ТОВАРОВ ПО ВЫРУЧКЕ"));
+        if (data.approx_capacity > 0) {
+            report_append(w, "Приблизительно (" + to_string(data.approx_capacity) + " счётчиков): настоящая выручка\n"
+                             "не больше указанной и не меньше её за вычетом погрешности\n\n");
+        }
+        report_append(w, "№   Артикул          Выручка\n");
+        report_append(w, "------------------------------------\n");
+        for (size_t i = 0; i < data.top_products.size(); i++) {
+            string line = to_string(i + 1) + ".  " + data.top_products[i].first + "        " +
+                          format_money(data.top_products[i].second) + " руб.";
+            if (i < data.top_errors.size()) {
+                line += "  (погрешность до " + format_money(data.top_errors[i]) + ")";
+            }
+            report_append(w, line + "\n");
+        }
+        report_append(w, "\n");
+    }
+
+    if (data.sections & REPORT_HISTOGRAM) {
+        report_append(w, format_header("РАСПРЕДЕЛЕНИЕ СУММ ЗАКАЗОВ"));
+        report_append(w, "Сумма заказа (руб.)              Заказов\n");
+        report_append(w, "-----------------------------------------\n");
+        for (size_t k = 0; k < data.order_value_histogram.size(); k++) {
+            string label = bucket_label((int)k);
+            // Выравниваем по символам, а не байтам (в подписи есть кириллица)
+            size_t width = 0;
+            for (char c : label) {
+                if (((unsigned char)c & 0xC0) != 0x80) width++;
+            }
+            report_append(w, label + string(width < 33 ? 33 - width : 1, ' ') +
+                             to_string(data.order_value_histogram[k]) + "\n");
+        }
+        report_append(w, "\n");
+    }
+}
+
+// Один JSON-объект с выбранными разделами
+static void write_json(ReportWriter& w, const ReportData& data) {
+    report_append(w, "{\n");
+    bool first_section = true;
+
+    auto begin_section = [&](const string& name) {
+        report_append(w, first_section ? "" : ",\n");
+        report_append(w, "  " + json_string(name) + ": ");
+        first_section = false;
+    };
+
+    if (data.sections & REPORT_SUMMARY) {
+        begin_section("summary");
+        report_append(w, "{\"orders\": " + to_string(data.order_count) +
+                         ", \"items\": " + to_string(data.item_count) +
+                         ", \"total_revenue\": " + format_money(data.total_revenue) +
+                         ", \"average_check\": " + format_money(data.average_check));
+        for (const auto& p : data.check_percentiles) {
+            report_append(w, ", \"p" + to_string(p.first) + "\": " + format_money(p.second));
+        }
+        if (data.has_distinct) {
+            report_append(w, ", \"distinct_orders\": " + to_string(data.distinct_orders) +
+                             ", \"distinct_skus\": " + to_string(data.distinct_skus) +
+                             ", \"daily_distinct_skus\": {");
+            bool first = true;
+            for (const auto& p : data.daily_distinct_skus) {
+                report_append(w, string(first ? "" : ", ") + json_string(p.first) + ": " + to_string(p.second));
+                first = false;
+            }
+            report_append(w, "}");
+        }
+        if (!data.date_from.empty()) report_append(w, ", \"from\": " + json_string(data.date_from));
+        if (!data.date_to.empty()) report_append(w, ", \"to\": " + json_string(data.date_to));
+        report_append(w, "}");
+    }
+
+    if (data.sections & REPORT_DAILY) {
+        begin_section("daily");
+        report_append(w, "[");
+        bool first = true;
+        for (const auto& p : data.daily_revenue) {
+            report_append(w, string(first ? "\n" : ",\n") + "    {\"date\": " + json_string(p.first) +
+                             ", \"revenue\": " + format_money(p.second) + "}");
+            first = false;
+        }
+        report_append(w, first ? "]" : "\n  ]");
+    }
+
+    if (data.sections & REPORT_TOP) {
+        begin_section("top");
+        report_append(w, "[");
+        for (size_t i = 0; i < data.top_products.size(); i++) {
+            string error = i < data.top_errors.size() ? ", \"error\": " + format_money(data.top_errors[i]) : "";
+            report_append(w, string(i == 0 ? "\n" : ",\n") + "    {\"rank\": " + to_string(i + 1) +
+                             ", \"sku\": " + json_string(data.top_products[i].first) +
+                             ", \"revenue\": " + format_money(data.top_products[i].second) + error + "}");
+        }
+        report_append(w, data.top_products.empty() ? "]" : "\n  ]");
+    }
+
+    if (data.sections & REPORT_HISTOGRAM) {
+        begin_section("histogram");
+        report_append(w, "[");
+        for (size_t k = 0; k < data.order_value_histogram.size(); k++) {
+            string from = k == 0 ? "0.00" : format_money(ORDER_VALUE_BOUNDS[k - 1]);
+            string to = k + 1 == (size_t)ORDER_VALUE_BUCKETS ? "null" : format_money(ORDER_VALUE_BOUNDS[k]);
+            report_append(w, string(k == 0 ? "\n" : ",\n") + "    {\"from\": " + from + ", \"to\": " + to +
+                             ", \"orders\": " + to_string(data.order_value_histogram[k]) + "}");
+        }
+        report_append(w, data.order_value_histogram.empty() ? "]" : "\n  ]");
+    }
+
+    report_append(w, "\n}\n");
+}
+
+// Длинная таблица section,key,value - один формат для всех разделов
+static void write_csv(ReportWriter& w, const ReportData& data) {
+    report_append(w, "section,key,value\n");
+
+    if (data.sections & REPORT_SUMMARY) {
+        report_append(w, "summary,orders," + to_string(data.order_count) + "\n");
+        report_append(w, "summary,items," + to_string(data.item_count) + "\n");
+        report_append(w, "summary,total_revenue," + format_money(data.total_revenue) + "\n");
+        report_append(w, "summary,average_check," + format_money(data.average_check) + "\n");
+        for (const auto& p : data.check_percentiles) {
+            report_append(w, "summary,p" + to_string(p.first) + "," + format_money(p.second) + "\n");
+        }
+        if (data.has_distinct) {
+            report_append(w, "summary,distinct_orders," + to_string(data.distinct_orders) + "\n");
+            report_append(w, "summary,distinct_skus," + to_string(data.distinct_skus) + "\n");
+            for (const auto& p : data.daily_distinct_skus) {
+                report_append(w, "distinct_skus_daily," + csv_field(p.first) + "," + to_string(p.second) + "\n");
+            }
+        }
+        if (!data.date_from.empty()) report_append(w, "summary,from," + data.date_from + "\n");
+        if (!data.date_to.empty()) report_append(w, "summary,to," + data.date_to + "\n");
+    }
+
+    if (data.sections & REPORT_DAILY) {
+        for (const auto& p : data.daily_revenue) {
+            report_append(w, "daily," + csv_field(p.first) + "," + format_money(p.second) + "\n");
+        }
+    }
+
+    if (data.sections & REPORT_TOP) {
+        for (size_t i = 0; i < data.top_products.size(); i++) {
+            const auto& p = data.top_products[i];
+            report_append(w, "top," + csv_field(p.first) + "," + format_money(p.second) + "\n");
+            if (i < data.top_errors.size()) {
+                report_append(w, "top_error," + csv_field(p.first) + "," + format_money(data.top_errors[i]) + "\n");
+            }
+        }
+    }
+
+    if (data.sections & REPORT_HISTOGRAM) {
+        for (size_t k = 0; k < data.order_value_histogram.size(); k++) {
+            // Ключ - нижняя граница корзины
+            string from = k == 0 ? "0.00" : format_money(ORDER_VALUE_BOUNDS[k - 1]);
+            report_append(w, "histogram," + from + "," + to_string(data.order_value_histogram[k]) + "\n");
+        }
+    }
+}
+
+ReportData make_report_data(const AnalyticsPart& stats, unsigned sections, int top_count) {
+    ReportData report;
+    report.sections = sections;
+    report.order_count = stats.order_count;
+    report.item_count = stats.item_count;
+    report.total_revenue = stats.total_revenue;
+    report.average_check = divide_money(stats.total_revenue, stats.order_count);
+    if (!stats.distinct_orders.registers.empty() || !stats.distinct_skus.registers.empty()) {
+        report.has_distinct = true;
+        report.distinct_orders = hll_estimate(stats.distinct_orders);
+        report.distinct_skus = hll_estimate(stats.distinct_skus);
+        for (const auto& p : stats.daily_distinct_skus) {
+            report.daily_distinct_skus[p.first] = hll_estimate(p.second);
+        }
+    }
+    if (stats.order_value_sketch.count > 0) {
+        for (int percentile : CHECK_PERCENTILES) {
+            report.check_percentiles.push_back(
+                make_pair(percentile, sketch_quantile(stats.order_value_sketch, percentile / 100.0)));
+        }
+    }
+    report.daily_revenue = stats.daily_revenue;
+    if ((sections & REPORT_TOP) && stats.approx_capacity > 0) {
+        report.approx_capacity = stats.approx_capacity;
+        for (const ApproxCounter& c : approx_top_products(stats, top_count)) {
+            report.top_products.push_back(make_pair(c.sku, c.count));
+            report.top_errors.push_back(c.error);
+        }
+    }
+    else if (sections & REPORT_TOP) {
+        report.top_products = top_products_from(stats, top_count);
+    }
+    report.order_value_histogram = stats.order_value_histogram;
+    return report;
+}
+
+void write_report(ReportWriter& writer, const ReportData& data, OutputFormat format) {
+    if (format == OUTPUT_JSON) write_json(writer, data);
+    else if (format == OUTPUT_CSV) write_csv(writer, data);
+    else write_text(writer, data);
+}
@@ -0,0 +1,364 @@
+#include "../include/segment_store.h"
+#include "../include/json_parser.h"
+#include "../include/input_files.h"
+#include "../include/uring_reader.h"
+#include "../include/gzip_reader.h"
+#include "../include/varint.h"
+#include "../include/sku_index.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+bool is_segment_file(const string& filename) {
+    size_t n = strlen(SEGMENT_EXTENSION);
+    return filename.size() > n && filename.compare(filename.size() - n, n, SEGMENT_EXTENSION) == 0;
+}
+
+bool is_segment(const string& data) {
+    return data.size() >= SEGMENT_V1_HEADER_SIZE && memcmp(data.data(), SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0;
+}
+
+// Пересекается ли период [min_ts, max_ts] с периодом options (по датам)
+static bool range_may_match(const string& min_ts, const string& max_ts, const ParseOptions& options) {
+    if (min_ts.empty()) return false;       // Заказов с датой нет
+    if (!options.date_from.empty() && max_ts.compare(0, 10, options.date_from) < 0) return false;
+    if (!options.date_to.empty() && min_ts.compare(0, 10, options.date_to) > 0) return false;
+    return true;
+}
+
+// То же для файла внутри сегмента (from_day/to_day - границы периода в днях)
+static bool entry_may_match(const SegmentEntry& entry, int from_day, int to_day) {
+    if (entry.undated) return true;     // Заказы без даты нужны проверке данных
+    return entry.dated && entry.max_day >= from_day && entry.min_day <= to_day;
+}
+
+static void put_string(string& out, const string& text) {
+    put_varint(out, text.size());
+    out += text;
+}
+
+static bool get_string(const unsigned char*& p, const unsigned char* end, string& text) {
+    uint64_t length;
+    if (!get_varint(p, end, length) || length > (uint64_t)(end - p)) return false;
+    text.assign((const char*)p, length);
+    p += length;
+    return true;
+}
+
+// Разобрать заголовок и каталог сегмента. false - сегмент повреждён
+static bool parse_segment(const string& data, SegmentHeader& header, vector<SegmentEntry>& entries) {
+    if (!is_segment(data)) return false;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, data.data(), SEGMENT_V1_HEADER_SIZE);
+    bool v1 = header.version == 1;
+    if (!v1) {
+        if (header.version != SEGMENT_VERSION || data.size() < sizeof(header)) return false;
+        memcpy(&header, data.data(), sizeof(header));
+    }
+    if (header.index_offset > data.size() || header.index_size > data.size() - header.index_offset) {
+        return false;
+    }
+
+    const unsigned char* p = (const unsigned char*)data.data() + header.index_offset;
+    const unsigned char* end = p + header.index_size;
+    entries.resize(header.file_count);
+    string previous;
+    uint64_t offset = v1 ? SEGMENT_V1_HEADER_SIZE : sizeof(SegmentHeader);
+    int previous_day = 0;
+    for (SegmentEntry& entry : entries) {
+        uint64_t shared, count, undated = 1, span, day;
+        string suffix;
+        if (!get_varint(p, end, shared) || shared > previous.size() || !get_string(p, end, suffix) ||
+            !get_varint(p, end, entry.length) || !get_varint(p, end, count) ||
+            (!v1 && !get_varint(p, end, undated)) || !get_varint(p, end, span) ||
+            entry.length > header.index_offset - offset) {
+            return false;
+        }
+        entry.name = previous.substr(0, shared) + suffix;
+        previous = entry.name;
+        entry.offset = offset;
+        offset += entry.length;
+        entry.order_count = (uint32_t)count;
+        entry.undated = undated != 0;       // В версии 1 неизвестно - считаем, что есть
+
+        // span: 0 - дат нет, иначе длина периода в днях + 1
+        entry.dated = span > 0;
+        if (entry.dated) {
+            if (!get_varint(p, end, day)) return false;
+            entry.min_day = previous_day + (int)unzigzag(day);
+            entry.max_day = entry.min_day + (int)span - 1;
+            previous_day = entry.min_day;
+        }
+    }
+    return true;
+}
+
+vector<Order> read_segment(const string& data, const ParseOptions& options) {
+    vector<Order> orders;
+    SegmentHeader header;
+    vector<SegmentEntry> entries;
+    if (!parse_segment(data, header, entries)) {
+        cerr << "Предупреждение: повреждён сегмент" << endl;
+        return orders;
+    }
+
+    bool ranged = !options.date_from.empty() || !options.date_to.empty();
+    int from_day = options.date_from.empty() ? INT_MIN : day_number(options.date_from);
+    int to_day = options.date_to.empty() ? INT_MAX : day_number(options.date_to);
+    for (const SegmentEntry& entry : entries) {
+        if (ranged && !entry_may_match(entry, from_day, to_day)) continue;
+        vector<Order> part = read_json(data.substr(entry.offset, entry.length), options);
+        for (Order& order : part) {
+            orders.push_back(move(order));
+        }
+    }
+    return orders;
+}
+
+bool segment_may_match(const string& path, const ParseOptions& options) {
+    if (options.date_from.empty() && options.date_to.empty()) return true;
+    if (!is_segment_file(path)) return true;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return true;       // Ошибку покажет чтение
+    SegmentHeader header;
+    bool read = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+    if (!read || memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0) return true;
+
+    // Заказы без даты (или сегмент версии 1, где о них не известно)
+    // отбрасывает не период, а проверка данных - такой сегмент нужен
+    if (header.version != SEGMENT_VERSION || header.undated_files > 0) return true;
+
+    header.min_ts[sizeof(header.min_ts) - 1] = '\0';
+    header.max_ts[sizeof(header.max_ts) - 1] = '\0';
+    return range_may_match(header.min_ts, header.max_ts, options);
+}
+
+// Сегмент, который собирается в памяти
+struct SegmentBuilder {
+    string body;
+    vector<SegmentEntry> entries;
+    vector<string> sources;     // Полные пути исходных файлов
+    string min_ts;
+    string max_ts;
+    uint32_t undated_files = 0;
+};
+
+// Записать сегмент, прочитать обратно и сверить; при remove_originals
+// после успешной сверки удалить исходные файлы
+static bool flush_segment(SegmentBuilder& segment, const CompactOptions& options, CompactStats& stats) {
+    if (segment.entries.empty()) return true;
+
+    string index;
+    string previous;
+    int previous_day = 0;
+    for (const SegmentEntry& entry : segment.entries) {
+        size_t shared = 0;
+        while (shared < previous.size() && shared < entry.name.size() && previous[shared] == entry.name[shared]) {
+            shared++;
+        }
+        put_varint(index, shared);
+        put_string(index, entry.name.substr(shared));
+        put_varint(index, entry.length);
+        put_varint(index, entry.order_count);
+        put_varint(index, entry.undated ? 1 : 0);
+        put_varint(index, entry.dated ? entry.max_day - entry.min_day + 1 : 0);
+        if (entry.dated) {
+            put_varint(index, zigzag(entry.min_day - previous_day));
+            previous_day = entry.min_day;
+        }
+        previous = entry.name;
+    }
+
+    SegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = SEGMENT_VERSION;
+    header.file_count = (uint32_t)segment.entries.size();
+    header.index_offset = sizeof(header) + segment.body.size();
+    header.index_size = index.size();
+    strncpy(header.min_ts, segment.min_ts.c_str(), sizeof(header.min_ts) - 1);
+    strncpy(header.max_ts, segment.max_ts.c_str(), sizeof(header.max_ts) - 1);
+    header.undated_files = segment.undated_files;
+
+    char name[32];
+    snprintf(name, sizeof(name), "segment_%06zu", stats.segments + 1);
+    string path = options.output_dir + "/" + name + SEGMENT_EXTENSION;
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        cerr << "Ошибка: не могу создать файл " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(segment.body.data(), 1, segment.body.size(), file) == segment.body.size() &&
+              fwrite(index.data(), 1, index.size(), file) == index.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        cerr << "Ошибка: не удалось записать " << path << endl;
+        return false;
+    }
+
+    stats.segments++;
+    stats.bytes_out += header.index_offset + header.index_size;
+
+    if (options.remove_originals) {
+        // Сверка: сегмент с диска совпадает с собранным, и в каждом файле
+        // столько же заказов, сколько было при сжатии
+        string written;
+        SegmentHeader check_header;
+        vector<SegmentEntry> check;
+        bool same = read_text_file(path, written) && parse_segment(written, check_header, check) &&
+                    check.size() == segment.entries.size() &&
+                    written.compare(sizeof(header), segment.body.size(), segment.body) == 0;
+        ParseOptions count_only;
+        count_only.fields = 0;
+        for (size_t k = 0; same && k < check.size(); k++) {
+            same = read_json(written.substr(check[k].offset, check[k].length), count_only).size() ==
+                   segment.entries[k].order_count;
+        }
+        if (!same) {
+            cerr << "Ошибка: сегмент " << path << " не совпал с исходными файлами, они не удалены" << endl;
+            return false;
+        }
+        for (const string& source : segment.sources) {
+            if (unlink(source.c_str()) == 0) {
+                stats.removed++;
+            } else {
+                cerr << "Предупреждение: не могу удалить " << source << ": " << strerror(errno) << endl;
+            }
+        }
+    }
+
+    cout << "  " << path << ": файлов " << segment.entries.size() << ", " << (header.index_offset + header.index_size) / 1024
+         << " КБ, " << (segment.min_ts.empty() ? string("без дат") : segment.min_ts + " - " + segment.max_ts) << endl;
+
+    segment = SegmentBuilder();
+    return true;
+}
+
+bool compact_directory(const string& dir, const CompactOptions& options, CompactStats& stats) {
+    vector<string> files;
+    for (const string& path : collect_input_files({dir}, options.threads)) {
+        if (!is_segment_file(path)) files.push_back(path);    // Готовые сегменты не трогаем
+    }
+    if (files.empty()) {
+        cout << "В " << dir << " нет файлов с заказами" << endl;
+        return false;
+    }
+
+    if (mkdir(options.output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        cerr << "Ошибка: не могу создать директорию " << options.output_dir << ": " << strerror(errno) << endl;
+        return false;
+    }
+    cout << "Сжатие " << dir << ": " << files.size() << " файлов -> " << options.output_dir << endl;
+
+    // Для каталога нужны только метки времени
+    ParseOptions ts_only;
+    ts_only.fields = FIELD_TS;
+
+    SegmentBuilder segment;
+    bool ok = true;
+    string prefix = dir.back() == '/' ? dir : dir + "/";
+
+    // Каждый файл должен попасть в сегменты ровно один раз и по порядку:
+    // повтор ушёл бы в сегмент, прошёл сверку и был бы удалён с исходными
+    size_t next_index = 0;
+    size_t added = 0;       // Файлов в сегментах
+    size_t skipped = 0;     // Неоткрывшихся и повреждённых
+
+    auto add_file = [&](size_t index, string& data) {
+        if (!ok) return;
+        if (index != next_index) {
+            cerr << "Ошибка: файл " << files[index] << " прочитан не по порядку (ожидался файл " << next_index
+                 << "), сжатие остановлено" << endl;
+            ok = false;
+            return;
+        }
+        next_index++;
+        stats.files++;
+        stats.bytes_in += data.size();
+
+        string text;
+        if (is_gzip(data)) {
+            if (!gunzip(data, text)) {
+                cerr << "Предупреждение: повреждён сжатый файл " << files[index] << ", пропущен" << endl;
+                skipped++;
+                return;
+            }
+        } else {
+            text = move(data);
+        }
+
+        SegmentEntry entry;
+        const string& path = files[index];
+        entry.name = path.compare(0, prefix.size(), prefix) == 0 ? path.substr(prefix.size()) : path;
+        entry.length = text.size();
+
+        vector<Order> orders = read_json(text, ts_only);
+        entry.order_count = (uint32_t)orders.size();
+        for (const Order& order : orders) {
+            if (order.date_time.empty()) {
+                entry.undated = true;
+                continue;
+            }
+            if (segment.min_ts.empty() || order.date_time < segment.min_ts) segment.min_ts = order.date_time;
+            if (segment.max_ts.empty() || order.date_time > segment.max_ts) segment.max_ts = order.date_time;
+
+            int day = day_number(order.date_time);
+            entry.min_day = entry.dated ? min(entry.min_day, day) : day;
+            entry.max_day = entry.dated ? max(entry.max_day, day) : day;
+            entry.dated = true;
+        }
+        stats.orders += orders.size();
+        if (entry.undated) segment.undated_files++;
+        segment.body += text;
+        segment.entries.push_back(move(entry));
+        segment.sources.push_back(path);
+        added++;
+
+        if (segment.body.size() >= options.segment_size) {
+            ok = flush_segment(segment, options, stats);
+        }
+    };
+
+    // Файлы читаются по порядку путей: порядок заказов сохраняется.
+    // Если io_uring недоступен или сломался посреди работы, остальные
+    // файлы дочитываются обычным чтением с первого неотданного
+    size_t delivered = 0;
+    uring_read_files(files, URING_QUEUE_DEPTH, add_file, delivered);
+    for (size_t k = delivered; k < files.size() && ok; k++) {
+        string data;
+        FILE* file = fopen(files[k].c_str(), "rb");
+        if (file == nullptr) {
+            cerr << "Предупреждение: не могу открыть файл " << files[k] << endl;
+            next_index++;
+            skipped++;
+            continue;
+        }
+        char chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            data.append(chunk, n);
+        }
+        fclose(file);
+        add_file(k, data);
+    }
+
+    // Сверка со списком файлов до записи последнего сегмента
+    if (ok && added + skipped != files.size()) {
+        cerr << "Ошибка: в сегменты попало " << added << " файлов из " << files.size() - skipped
+             << ", последний сегмент не записан" << endl;
+        ok = false;
+    }
+
+    return ok && flush_segment(segment, options, stats);
+}
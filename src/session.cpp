@@ -0,0 +1,261 @@
+#include "../include/session.h"
+#include "../include/input_files.h"
+#include "../include/validation.h"
+#include "../include/report_writer.h"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+
+using namespace std;
+
+// Сумма с разделителями тысяч: "14,287,563.42"
+static string format_money_grouped(Money amount) {
+    string plain = format_money(amount);
+    size_t sign = plain[0] == '-' ? 1 : 0;
+    size_t point = plain.find('.');
+    string result = plain.substr(0, sign);
+    for (size_t k = sign; k < point; k++) {
+        if (k > sign && (point - k) % 3 == 0) result += ',';
+        result += plain[k];
+    }
+    return result + plain.substr(point);
+}
+
+static string join_paths(const vector<string>& paths) {
+    string result;
+    for (size_t k = 0; k < paths.size(); k++) {
+        if (k > 0) result += ", ";
+        result += paths[k];
+    }
+    return result;
+}
+
+bool session_load(SessionData& data, const vector<string>& inputs, const LoadOptions& options,
+                  SessionLog& log) {
+    auto start = chrono::steady_clock::now();
+
+    vector<string> files = collect_input_files(inputs, options.parser_threads);
+    if (files.empty()) {
+        cout << "Ошибка: не найдено файлов с заказами" << endl;
+        return false;
+    }
+
+    // В памяти держим все поля и все метрики: команды могут спросить что угодно
+    LoadOptions load_options = options;
+    load_options.parse.fields = FIELDS_ALL;
+    load_options.metrics = METRICS_ALL;
+    load_options.show_progress = false;
+    LoadResult loaded = load_files(files, load_options);
+
+    ValidationOptions validation_options;
+    validation_options.threads = options.parser_threads;
+    validation_options.sample_size = 0;
+    ValidationResult check = validate_orders(loaded.orders, validation_options);
+
+    data.inputs = inputs;
+    data.orders = move(loaded.orders);
+    data.stats = move(loaded.analytics);
+    data.file_count = files.size();
+
+    log.files += files.size();
+    log.orders += data.orders.size();
+    log.revenue += data.stats.total_revenue;
+    log.loads.push_back(make_pair(join_paths(inputs), (long long)data.orders.size()));
+
+    long long ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    cout << "Загружено: " << files.size() << " файлов, " << data.orders.size() << " заказов за " << ms << " мс"
+         << endl;
+    if (options.dedup.mode != DEDUP_OFF) {
+        print_dedup_stats(loaded.dedup, options.dedup);
+    }
+    if (check.total > 0) {
+        cout << "Внимание: в данных " << check.total << " ошибок (подробности - при обычном запуске)" << endl;
+    }
+    return true;
+}
+
+static void session_help() {
+    cout << "Команды:" << endl;
+    cout << "  top [N]            Топ N товаров по выручке" << endl;
+    cout << "  daily [С [ПО]]     Выручка по дням (YYYY-MM-DD)" << endl;
+    cout << "  sku АРТИКУЛ        Выручка артикула и его место" << endl;
+    cout << "  stats              Общая статистика" << endl;
+    cout << "  reload [ПУТЬ ...]  Перечитать данные (без путей - те же)" << endl;
+    cout << "  help               Эта справка" << endl;
+    cout << "  exit               Завершить сессию" << endl;
+}
+
+string answer_stats(const SessionData& data) {
+    string text = format_header("ОБЩАЯ СТАТИСТИКА");
+    text += "Источник:             " + join_paths(data.inputs) + "\n";
+    text += "Файлов:               " + to_string(data.file_count) + "\n";
+    text += "Всего заказов:        " + to_string(data.stats.order_count) + "\n";
+    text += "Общая выручка:        " + format_money(data.stats.total_revenue) + " руб.\n";
+    text += "Средний чек:          " + format_money(divide_money(data.stats.total_revenue, data.stats.order_count)) +
+            " руб.\n";
+    for (int percentile : CHECK_PERCENTILES) {
+        string label = "Чек p" + to_string(percentile) + ":";
+        text += label + string(25 - label.size(), ' ') +
+                format_money(sketch_quantile(data.stats.order_value_sketch, percentile / 100.0)) + " руб.\n";
+    }
+    text += "Всего товаров:        " + to_string(data.stats.item_count) + "\n";
+    text += "Разных заказов:       " + to_string(hll_estimate(data.stats.distinct_orders)) + " (оценка)\n";
+    text += "Разных артикулов:     " + to_string(hll_estimate(data.stats.distinct_skus)) + " (оценка)\n";
+    return text;
+}
+
+string answer_top(const SessionData& data, int top_count) {
+    vector<pair<string, Money>> top = top_products_from(data.stats, top_count);
+    string text = format_header("ТОП ТОВАРОВ ПО ВЫРУЧКЕ");
+    text += "№   Артикул          Выручка\n";
+    text += "------------------------------------\n";
+    for (size_t i = 0; i < top.size(); i++) {
+        text += to_string(i + 1) + ".  " + top[i].first + "        " + format_money(top[i].second) + " руб.\n";
+    }
+    return text;
+}
+
+string answer_daily(const SessionData& data, const string& from, const string& to) {
+    string text = format_header("ВЫРУЧКА ПО ДНЯМ");
+    text += "Дата            Выручка\n";
+    text += "--------------------------------\n";
+
+    Money total = 0;
+    int days = 0;
+    auto it = from.empty() ? data.stats.daily_revenue.begin() : data.stats.daily_revenue.lower_bound(from);
+    for (; it != data.stats.daily_revenue.end(); ++it) {
+        if (!to.empty() && it->first.compare(0, 10, to) > 0) break;
+        text += it->first + "      " + format_money(it->second) + " руб.\n";
+        total += it->second;
+        days++;
+    }
+    text += "--------------------------------\n";
+    text += "Дней: " + to_string(days) + ", итого " + format_money(total) + " руб.\n";
+    return text;
+}
+
+string answer_sku(const SessionData& data, const string& sku) {
+    SkuId id = find_sku(sku);
+    if (id == EMPTY_SKU || id >= data.stats.product_lines.size() || data.stats.product_lines[id] == 0) {
+        return "Артикул " + sku + " не встречается в данных\n";
+    }
+
+    // Место в топе: сколько артикулов заработали больше
+    Money revenue = data.stats.product_revenue[id];
+    size_t rank = 1;
+    for (size_t k = 0; k < data.stats.product_revenue.size(); k++) {
+        if (data.stats.product_revenue[k] > revenue) rank++;
+    }
+
+    string text = format_header("АРТИКУЛ " + sku);
+    text += "Выручка:              " + format_money(revenue) + " руб.\n";
+    text += "Позиций в заказах:    " + to_string(data.stats.product_lines[id]) + "\n";
+    text += "Место по выручке:     " + to_string(rank) + "\n";
+    return text;
+}
+
+// Отчёт по сессии (печатается при выходе)
+static void print_session_report(const SessionLog& log, const SessionData& data) {
+    time_t now = time(nullptr);
+    string date = ctime(&now);
+    if (!date.empty() && date.back() == '\n') date.pop_back();
+
+    long long seconds = chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now() - log.start).count();
+
+    string text = "=== ОТЧЁТ ПО СЕССИИ ===\n";
+    text += "Дата и время отчёта: " + date + "\n";
+    text += "Продолжительность сессии: " + to_string(seconds / 3600) + "ч " + to_string(seconds / 60 % 60) + "м " +
+            to_string(seconds % 60) + "с\n";
+    text += "Общее количество введённых команд: " + to_string(log.commands) + "\n";
+    text += "Общее количество обработанных файлов: " + to_string(log.files) + "\n";
+    text += "Общее количество проанализированных заказов: " + to_string(log.orders) + "\n";
+    text += "Общая выручка: " + format_money_grouped(log.revenue) + " руб.\n";
+    text += "Средний чек: " + format_money_grouped(divide_money(log.revenue, log.orders)) + " руб.\n";
+
+    text += "\nОбработано файлов по операциям:\n";
+    for (const auto& load : log.loads) {
+        text += "  " + load.first + ": " + to_string(load.second) + " заказов\n";
+    }
+
+    vector<pair<string, Money>> top = top_products_from(data.stats, 5);
+    if (!top.empty()) {
+        text += "\nТоп-5 товаров по выручке:\n";
+        for (const auto& p : top) {
+            text += "  " + p.first + ": " + format_money_grouped(p.second) + " руб.\n";
+        }
+    }
+    text += "========================\n";
+    cout << text;
+}
+
+int run_session(const vector<string>& inputs, const LoadOptions& options, int top_count) {
+    SessionData data;
+    SessionLog log;
+
+    cout << "Загрузка из " << join_paths(inputs) << "..." << endl;
+    if (!session_load(data, inputs, options, log)) {
+        return 1;
+    }
+    cout << "Введите команду (help - список команд)" << endl;
+
+    string line;
+    while (true) {
+        cout << "> " << flush;
+        if (!getline(cin, line)) break;
+
+        istringstream words(line);
+        string command;
+        if (!(words >> command)) continue;
+        if (command == "exit" || command == "quit") break;
+
+        log.commands++;
+        auto start = chrono::steady_clock::now();
+
+        if (command == "help") {
+            session_help();
+            continue;
+        }
+        else if (command == "stats") {
+            cout << answer_stats(data);
+        }
+        else if (command == "top") {
+            int n = top_count;
+            words >> n;
+            cout << answer_top(data, n);
+        }
+        else if (command == "daily") {
+            string from, to;
+            words >> from >> to;
+            cout << answer_daily(data, from, to);
+        }
+        else if (command == "sku") {
+            string sku;
+            if (!(words >> sku)) {
+                cout << "Укажите артикул: sku АРТИКУЛ" << endl;
+                continue;
+            }
+            cout << answer_sku(data, sku);
+        }
+        else if (command == "reload") {
+            vector<string> paths;
+            string path;
+            while (words >> path) paths.push_back(path);
+            session_load(data, paths.empty() ? data.inputs : paths, options, log);
+        }
+        else {
+            cout << "Неизвестная команда " << command << " (help - список команд)" << endl;
+            continue;
+        }
+
+        double ms = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count() / 1000.0;
+        char timing[64];
+        snprintf(timing, sizeof(timing), "(%.2f мс)\n", ms);
+        cout << timing;
+    }
+
+    cout << endl;
+    print_session_report(log, data);
+    return 0;
+}
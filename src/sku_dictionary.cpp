@@ -0,0 +1,65 @@
+#include "../include/sku_dictionary.h"
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+using namespace std;
+
+// Словарь артикулов: deque не двигает строки, поэтому ключи-string_view
+// в хеш-таблице остаются валидными при добавлении новых артикулов
+struct SkuDictionary {
+    deque<string> names;
+    unordered_map<string_view, SkuId> ids;
+    shared_mutex lock;
+
+    SkuDictionary() {
+        names.push_back("");
+        ids[names.back()] = EMPTY_SKU;
+    }
+};
+
+// Создаётся при первом обращении (без проблем порядка инициализации)
+static SkuDictionary& dictionary() {
+    static SkuDictionary instance;
+    return instance;
+}
+
+SkuId intern_sku(string_view sku) {
+    SkuDictionary& dict = dictionary();
+
+    // Частый случай: артикул уже есть, хватает разделяемой блокировки
+    {
+        shared_lock<shared_mutex> read_lock(dict.lock);
+        auto it = dict.ids.find(sku);
+        if (it != dict.ids.end()) return it->second;
+    }
+
+    unique_lock<shared_mutex> write_lock(dict.lock);
+    auto it = dict.ids.find(sku);
+    if (it != dict.ids.end()) return it->second;
+
+    SkuId id = (SkuId)dict.names.size();
+    dict.names.emplace_back(sku);
+    dict.ids.emplace(dict.names.back(), id);
+    return id;
+}
+
+SkuId find_sku(string_view sku) {
+    SkuDictionary& dict = dictionary();
+    shared_lock<shared_mutex> read_lock(dict.lock);
+    auto it = dict.ids.find(sku);
+    return it != dict.ids.end() ? it->second : EMPTY_SKU;
+}
+
+const string& sku_name(SkuId id) {
+    SkuDictionary& dict = dictionary();
+    shared_lock<shared_mutex> read_lock(dict.lock);
+    return dict.names[id];
+}
+
+size_t sku_count() {
+    SkuDictionary& dict = dictionary();
+    shared_lock<shared_mutex> read_lock(dict.lock);
+    return dict.names.size();
+}
@@ -0,0 +1,243 @@
+#include "../include/sku_index.h"
+#include "../include/varint.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+
+using namespace std;
+
+// Дни от 1970-01-01 по григорианскому календарю (алгоритм days_from_civil)
+static int days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+int day_number(const string& date) {
+    if (date.length() < 10) return 0;
+    int y = atoi(date.substr(0, 4).c_str());
+    int m = atoi(date.substr(5, 2).c_str());
+    int d = atoi(date.substr(8, 2).c_str());
+    return days_from_civil(y, m, d);
+}
+
+string day_date(int day) {
+    // Обратное преобразование (civil_from_days)
+    day += 719468;
+    int era = (day >= 0 ? day : day - 146096) / 146097;
+    int doe = day - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    int d = doy - (153 * mp + 2) / 5 + 1;
+    int m = mp + (mp < 10 ? 3 : -9);
+    int y = yoe + era * 400 + (m <= 2);
+
+    char text[32];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d", y, m, d);
+    return text;
+}
+
+bool write_sku_index(const string& path, const vector<Order>& orders, SkuIndexStats& stats) {
+    // Продажи по артикулам и дням (номер артикула -> день -> итог)
+    vector<map<int, SkuPosting>> by_sku(sku_count());
+    for (const Order& order : orders) {
+        int day = day_number(order.date_time);
+        for (const Item& item : order.items) {
+            SkuPosting& posting = by_sku[item.sku][day];
+            posting.day = day;
+            posting.quantity += item.quantity;
+            posting.revenue += (Money)item.quantity * item.price;
+        }
+    }
+
+    // Артикулы по алфавиту: каталог упорядочен по тексту артикула
+    vector<SkuId> ids;
+    for (size_t k = 0; k < by_sku.size(); k++) {
+        if (k != EMPTY_SKU && !by_sku[k].empty()) ids.push_back((SkuId)k);
+    }
+    sort(ids.begin(), ids.end(), [](SkuId a, SkuId b) { return sku_name(a) < sku_name(b); });
+
+    string body;
+    string directory;
+    string blocks;
+    stats = SkuIndexStats();
+    for (size_t k = 0; k < ids.size(); k++) {
+        SkuId id = ids[k];
+
+        // Каталог режется на блоки: в верхний уровень попадают первый
+        // артикул блока и границы блока в каталоге
+        if (k % SKU_INDEX_BLOCK == 0) {
+            if (k > 0) put_varint(blocks, directory.size());
+            put_varint(blocks, sku_name(id).size());
+            blocks += sku_name(id);
+            put_varint(blocks, directory.size());
+        }
+
+        size_t offset = sizeof(SkuIndexHeader) + body.size();
+        int previous_day = 0;
+        for (const auto& p : by_sku[id]) {
+            put_varint(body, zigzag(p.second.day - previous_day));
+            put_varint(body, zigzag(p.second.quantity));
+            put_varint(body, zigzag(p.second.revenue));
+            previous_day = p.second.day;
+        }
+
+        const string& name = sku_name(id);
+        put_varint(directory, name.size());
+        directory += name;
+        put_varint(directory, offset);
+        put_varint(directory, sizeof(SkuIndexHeader) + body.size() - offset);
+        put_varint(directory, by_sku[id].size());
+
+        stats.sku_count++;
+        stats.posting_count += by_sku[id].size();
+    }
+
+    if (!ids.empty()) put_varint(blocks, directory.size());
+
+    SkuIndexHeader header;
+    memcpy(header.magic, SKU_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SKU_INDEX_VERSION;
+    header.sku_count = (uint32_t)ids.size();
+    header.directory_offset = sizeof(SkuIndexHeader) + body.size();
+    header.directory_size = directory.size();
+    header.blocks_offset = header.directory_offset + header.directory_size;
+    header.blocks_size = blocks.size();
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        cerr << "Ошибка: не могу создать файл " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(body.data(), 1, body.size(), file) == body.size() &&
+              fwrite(directory.data(), 1, directory.size(), file) == directory.size() &&
+              fwrite(blocks.data(), 1, blocks.size(), file) == blocks.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        cerr << "Ошибка: не удалось записать индекс " << path << endl;
+        return false;
+    }
+
+    stats.file_size = header.blocks_offset + header.blocks_size;
+    return true;
+}
+
+// Прочитать size байт с позиции offset
+static bool read_at(FILE* file, uint64_t offset, size_t size, string& out) {
+    out.resize(size);
+    if (fseek(file, (long)offset, SEEK_SET) != 0) return false;
+    return fread(&out[0], 1, size, file) == size;
+}
+
+bool read_sku_postings(const string& path, const string& sku, vector<SkuPosting>& postings, bool& found) {
+    postings.clear();
+    found = false;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        cerr << "Ошибка: не могу открыть индекс " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+
+    SkuIndexHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, SKU_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SKU_INDEX_VERSION) {
+        cerr << "Ошибка: " << path << " - не индекс артикулов" << endl;
+        fclose(file);
+        return false;
+    }
+
+    // Верхний уровень каталога: последний блок, первый артикул которого не больше искомого
+    string blocks;
+    if (!read_at(file, header.blocks_offset, header.blocks_size, blocks)) {
+        cerr << "Ошибка: индекс " << path << " повреждён" << endl;
+        fclose(file);
+        return false;
+    }
+
+    // Запись блока: длина артикула, артикул, начало, конец
+    const unsigned char* p = (const unsigned char*)blocks.data();
+    const unsigned char* end = p + blocks.size();
+    uint64_t block_begin = 0, block_end = 0;
+    bool have_block = false;
+    while (p < end) {
+        uint64_t length, begin, finish;
+        if (!get_varint(p, end, length) || (uint64_t)(end - p) < length) break;
+        string first((const char*)p, length);
+        p += length;
+        if (!get_varint(p, end, begin) || !get_varint(p, end, finish)) break;
+        if (first > sku) break;
+        block_begin = begin;
+        block_end = finish;
+        have_block = true;
+    }
+
+    string directory;
+    if (have_block && (block_end < block_begin ||
+                       !read_at(file, header.directory_offset + block_begin, block_end - block_begin, directory))) {
+        cerr << "Ошибка: индекс " << path << " повреждён" << endl;
+        fclose(file);
+        return false;
+    }
+
+    // Блок каталога: ищем артикул, пока не дошли до больших по алфавиту
+    p = (const unsigned char*)directory.data();
+    end = p + directory.size();
+    uint64_t offset = 0, size = 0, count = 0;
+    while (p < end) {
+        uint64_t length;
+        if (!get_varint(p, end, length) || (uint64_t)(end - p) < length) break;
+        string name((const char*)p, length);
+        p += length;
+        if (!get_varint(p, end, offset) || !get_varint(p, end, size) || !get_varint(p, end, count)) break;
+
+        if (name == sku) {
+            found = true;
+            break;
+        }
+        if (name > sku) break;
+    }
+
+    if (!found) {
+        fclose(file);
+        return true;
+    }
+
+    // Список записей только этого артикула
+    string block;
+    bool ok = read_at(file, offset, size, block);
+    fclose(file);
+    if (!ok) {
+        cerr << "Ошибка: индекс " << path << " повреждён" << endl;
+        return false;
+    }
+
+    p = (const unsigned char*)block.data();
+    end = p + block.size();
+    int day = 0;
+    for (uint64_t k = 0; k < count; k++) {
+        uint64_t delta, quantity, revenue;
+        if (!get_varint(p, end, delta) || !get_varint(p, end, quantity) || !get_varint(p, end, revenue)) {
+            cerr << "Ошибка: индекс " << path << " повреждён" << endl;
+            return false;
+        }
+        day += (int)unzigzag(delta);
+
+        SkuPosting posting;
+        posting.day = day;
+        posting.quantity = unzigzag(quantity);
+        posting.revenue = unzigzag(revenue);
+        postings.push_back(posting);
+    }
+    return true;
+}
@@ -0,0 +1,205 @@
+#include "../include/spill_table.h"
+#include "../include/sku_dictionary.h"
+#include "../include/metrics_pipeline.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+// Записей за одно чтение временного файла
+const size_t SPILL_READ_RECORDS = 4096;
+
+// Часть по артикулу: номера идут подряд, поэтому их перемешиваем
+static int partition_of(SkuId sku) {
+    return (int)((sku * 0x9E3779B1u) >> 26);
+}
+
+// Временный файл в $TMPDIR (или /tmp); имя удаляется сразу,
+// файл исчезает при закрытии или аварийном выходе
+static FILE* open_spill_file() {
+    const char* dir = getenv("TMPDIR");
+    string path = string(dir != nullptr && *dir != '\0' ? dir : "/tmp") + "/sales_spill_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) return nullptr;
+    unlink(path.c_str());
+    FILE* file = fdopen(fd, "w+b");
+    if (file == nullptr) {
+        close(fd);
+        return nullptr;
+    }
+    // Пишем большими блоками сами: без буфера недописанный блок можно отрезать
+    setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+}
+
+SpillTable::SpillTable(size_t memory_limit, int top_count)
+    : max_entries(max(SPILL_MIN_ENTRIES, memory_limit / SPILL_ENTRY_BYTES)), top_count(top_count) {}
+
+SpillTable::~SpillTable() {
+    for (FILE* file : files) {
+        if (file != nullptr) fclose(file);
+    }
+}
+
+// Сбросить на диск самую большую часть
+static void spill_largest(SpillTable& table) {
+    int largest = 0;
+    for (int p = 1; p < SPILL_PARTITIONS; p++) {
+        if (table.partitions[p].size() > table.partitions[largest].size()) largest = p;
+    }
+    unordered_map<SkuId, SpillTotals>& part = table.partitions[largest];
+
+    vector<SpillRecord> records;
+    records.reserve(part.size());
+    for (const auto& e : part) {
+        records.push_back({e.first, e.second.lines, e.second.revenue});
+    }
+
+    FILE*& file = table.files[largest];
+    if (file == nullptr) file = open_spill_file();
+    long written = file != nullptr ? ftell(file) : 0;
+    if (file == nullptr || fwrite(records.data(), sizeof(SpillRecord), records.size(), file) != records.size()) {
+        // Недописанные записи отрезаем (часть остаётся в памяти) и считаем
+        // дальше без сбросов: результат важнее лимита
+        int error = errno;
+        if (file != nullptr && ftruncate(fileno(file), written) == 0) fseek(file, written, SEEK_SET);
+        cerr << "Предупреждение: не удалось записать временный файл (" << strerror(error)
+             << "), выручка по артикулам считается без лимита памяти" << endl;
+        table.max_entries = SIZE_MAX;
+        return;
+    }
+
+    table.spill_count++;
+    table.spilled_bytes += records.size() * sizeof(SpillRecord);
+    table.entries -= part.size();
+    unordered_map<SkuId, SpillTotals>().swap(part);     // clear() оставил бы корзины
+}
+
+void SpillTable::add(SkuId sku, Money revenue) {
+    auto inserted = partitions[partition_of(sku)].try_emplace(sku);
+    inserted.first->second.revenue += revenue;
+    inserted.first->second.lines++;
+    if (inserted.second && ++entries > max_entries) {
+        spill_largest(*this);
+    }
+}
+
+void spill_add_orders(SpillTable& table, const vector<Order>& orders, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        for (const Item& item : orders[i].items) {
+            table.add(item.sku, (Money)item.quantity * item.price);
+        }
+    }
+}
+
+void spill_finish(const vector<SpillTable*>& tables, AnalyticsPart& result) {
+    int top_count = tables.empty() ? 0 : tables[0]->top_count;
+
+    // Куча топа: в корне худший из отобранных. Порядок - как в
+    // top_products_from: по выручке, при равенстве - по тексту артикула
+    auto better = [](const pair<SkuId, Money>& a, const pair<SkuId, Money>& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return sku_name(a.first) < sku_name(b.first);
+    };
+    vector<pair<SkuId, Money>> top;
+
+    // Часть собирается из всех таблиц сразу: в памяти одна часть, а не все артикулы
+    vector<SpillRecord> buffer(SPILL_READ_RECORDS);
+    for (int p = 0; p < SPILL_PARTITIONS; p++) {
+        unordered_map<SkuId, SpillTotals> merged;
+        auto add = [&](SkuId sku, uint32_t lines, Money revenue) {
+            SpillTotals& totals = merged[sku];
+            totals.revenue += revenue;
+            totals.lines += lines;
+        };
+
+        for (SpillTable* table : tables) {
+            FILE*& file = table->files[p];
+            if (file != nullptr) {
+                rewind(file);
+                size_t n;
+                while ((n = fread(buffer.data(), sizeof(SpillRecord), buffer.size(), file)) > 0) {
+                    for (size_t k = 0; k < n; k++) {
+                        add(buffer[k].sku, buffer[k].lines, buffer[k].revenue);
+                    }
+                }
+                if (ferror(file)) {
+                    cerr << "Предупреждение: ошибка чтения временного файла, выручка по артикулам неполная" << endl;
+                }
+                fclose(file);
+                file = nullptr;
+            }
+
+            for (const auto& e : table->partitions[p]) {
+                add(e.first, e.second.lines, e.second.revenue);
+            }
+            unordered_map<SkuId, SpillTotals>().swap(table->partitions[p]);
+        }
+
+        // Частичным итогам нужны все артикулы: записи части идут в итог как есть
+        if (top_count <= 0) {
+            for (const auto& e : merged) {
+                result.product_totals.push_back({e.first, e.second.lines, e.second.revenue});
+            }
+            continue;
+        }
+
+        for (const auto& e : merged) {
+            top.push_back(make_pair(e.first, e.second.revenue));
+            push_heap(top.begin(), top.end(), better);
+            if (top.size() > (size_t)top_count) {
+                pop_heap(top.begin(), top.end(), better);
+                top.pop_back();
+            }
+        }
+    }
+
+    sort_heap(top.begin(), top.end(), better);
+    result.product_top = move(top);
+    for (SpillTable* table : tables) {
+        table->entries = 0;
+        result.spill_count += table->spill_count;
+        result.spilled_bytes += table->spilled_bytes;
+    }
+}
+
+void spill_aggregate(const vector<Order>& orders, int threads, size_t memory_limit, int top_count,
+                     AnalyticsPart& result) {
+    size_t thread_count = threads > 1 ? (size_t)threads : 1;
+    thread_count = min(thread_count, max<size_t>(1, orders.size() / MIN_ORDERS_PER_THREAD));
+
+    // Бюджет делится между потоками поровну
+    vector<unique_ptr<SpillTable>> tables;
+    vector<SpillTable*> parts;
+    for (size_t t = 0; t < thread_count; t++) {
+        tables.push_back(make_unique<SpillTable>(memory_limit / thread_count, top_count));
+        parts.push_back(tables.back().get());
+    }
+
+    if (thread_count == 1) {
+        spill_add_orders(*parts[0], orders, 0, orders.size());
+    }
+    else {
+        size_t chunk = (orders.size() + thread_count - 1) / thread_count;
+        vector<thread> workers;
+        for (size_t t = 0; t < thread_count; t++) {
+            size_t begin = min(orders.size(), t * chunk);
+            size_t end = min(orders.size(), begin + chunk);
+            workers.emplace_back([&parts, &orders, t, begin, end]() {
+                spill_add_orders(*parts[t], orders, begin, end);
+            });
+        }
+        for (thread& w : workers) {
+            w.join();
+        }
+    }
+
+    spill_finish(parts, result);
+}
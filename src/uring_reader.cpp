@@ -0,0 +1,361 @@
+#include "../include/uring_reader.h"
+#include <iostream>
+#include <map>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+
+// Начальный размер буфера под файл (файлы заказов обычно меньше)
+static const size_t URING_INITIAL_BUFFER = 64 * 1024;
+
+// Кольца io_uring, отображённые в память процесса
+struct Uring {
+    int fd = -1;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_entries = 0;
+    io_uring_sqe* sqes = nullptr;
+
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    void* sq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    void* cq_ring = MAP_FAILED;
+    size_t cq_ring_size = 0;
+    size_t sqes_size = 0;
+
+    unsigned to_submit = 0;     // Заполнено, но ещё не отправлено в ядро
+};
+
+static void uring_close(Uring& ring) {
+    if (ring.sqes != nullptr) munmap(ring.sqes, ring.sqes_size);
+    if (ring.cq_ring != MAP_FAILED && ring.cq_ring != ring.sq_ring) munmap(ring.cq_ring, ring.cq_ring_size);
+    if (ring.sq_ring != MAP_FAILED) munmap(ring.sq_ring, ring.sq_ring_size);
+    if (ring.fd >= 0) close(ring.fd);
+    ring = Uring();
+}
+
+// Поддерживает ли ядро нужные операции (IORING_REGISTER_PROBE, Linux 5.6+)
+static bool uring_probe_ops(int fd) {
+    size_t size = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    vector<unsigned char> storage(size, 0);
+    io_uring_probe* probe = (io_uring_probe*)storage.data();
+
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        return false;
+    }
+
+    const int needed[] = { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE };
+    for (int op : needed) {
+        if (op > probe->last_op) return false;
+        if ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) return false;
+    }
+    return true;
+}
+
+static bool uring_setup(Uring& ring, unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring.fd < 0) return false;
+
+    if (!uring_probe_ops(ring.fd)) {
+        uring_close(ring);
+        return false;
+    }
+
+    ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    // Новые ядра отдают оба кольца одним отображением
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        ring.sq_ring_size = max(ring.sq_ring_size, ring.cq_ring_size);
+    }
+
+    ring.sq_ring = mmap(nullptr, ring.sq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (ring.sq_ring == MAP_FAILED) {
+        uring_close(ring);
+        return false;
+    }
+
+    if (single_mmap) {
+        ring.cq_ring = ring.sq_ring;
+    } else {
+        ring.cq_ring = mmap(nullptr, ring.cq_ring_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+        if (ring.cq_ring == MAP_FAILED) {
+            uring_close(ring);
+            return false;
+        }
+    }
+
+    ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        uring_close(ring);
+        return false;
+    }
+    ring.sqes = (io_uring_sqe*)sqes;
+
+    char* sq = (char*)ring.sq_ring;
+    ring.sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring.sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring.sq_entries = params.sq_entries;
+
+    char* cq = (char*)ring.cq_ring;
+    ring.cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring.cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+// Взять свободную запись очереди отправки (nullptr - очередь заполнена)
+static io_uring_sqe* uring_get_sqe(Uring& ring) {
+    unsigned head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring.sq_tail;
+    if (tail - head >= ring.sq_entries) return nullptr;
+
+    unsigned index = tail & *ring.sq_mask;
+    io_uring_sqe* sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sq_array[index] = index;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring.to_submit++;
+    return sqe;
+}
+
+// Отправить накопленное и дождаться хотя бы одного завершения
+static bool uring_submit_and_wait(Uring& ring) {
+    while (true) {
+        long ret = syscall(__NR_io_uring_enter, ring.fd, ring.to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret >= 0) {
+            ring.to_submit -= min<unsigned>(ring.to_submit, (unsigned)ret);
+            return true;
+        }
+        if (errno != EINTR) return false;
+    }
+}
+
+// Состояние одного файла в очереди
+enum UringStage { STAGE_OPEN, STAGE_READ, STAGE_CLOSE };
+
+struct UringSlot {
+    size_t index = 0;       // Номер файла в списке путей
+    int fd = -1;
+    UringStage stage = STAGE_OPEN;
+    string data;            // Буфер под содержимое
+    size_t length = 0;      // Сколько байт уже прочитано
+    bool failed = false;
+};
+
+// Поставить чтение следующей части файла
+static bool prep_read(Uring& ring, UringSlot& slot, size_t slot_id) {
+    if (slot.data.size() - slot.length == 0) {
+        slot.data.resize(slot.data.size() * 2);
+    }
+    io_uring_sqe* sqe = uring_get_sqe(ring);
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = slot.fd;
+    sqe->addr = (uint64_t)(uintptr_t)(slot.data.data() + slot.length);
+    sqe->len = (uint32_t)(slot.data.size() - slot.length);
+    sqe->off = slot.length;
+    sqe->user_data = slot_id;
+    slot.stage = STAGE_READ;
+    return true;
+}
+
+// Поставить закрытие файла
+static bool prep_close(Uring& ring, UringSlot& slot, size_t slot_id) {
+    io_uring_sqe* sqe = uring_get_sqe(ring);
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = slot.fd;
+    sqe->user_data = slot_id;
+    slot.stage = STAGE_CLOSE;
+    return true;
+}
+
+bool uring_available() {
+    Uring ring;
+    if (!uring_setup(ring, 8)) return false;
+    uring_close(ring);
+    return true;
+}
+
+bool uring_read_files(const vector<string>& paths, size_t queue_depth,
+                      const function<void(size_t index, string& contents)>& on_file, size_t& delivered) {
+    delivered = 0;
+    if (queue_depth == 0) queue_depth = 1;
+
+    // На каждый файл в очереди - не больше одной операции одновременно
+    Uring ring;
+    if (!uring_setup(ring, (unsigned)queue_depth)) return false;
+    queue_depth = min<size_t>(queue_depth, ring.sq_entries);
+
+    vector<UringSlot> slots(queue_depth);
+    vector<size_t> free_slots;
+    for (size_t k = queue_depth; k > 0; k--) {
+        free_slots.push_back(k - 1);
+    }
+
+    // Готовые файлы ждут здесь, пока не подойдёт их очередь по порядку
+    map<size_t, string> completed;
+    size_t next_file = 0;       // Следующий файл для открытия
+    size_t next_deliver = 0;    // Следующий файл для on_file
+
+    while (next_deliver < paths.size()) {
+        // Открываем новые файлы, пока есть свободные места. Окно ограничено,
+        // чтобы медленный файл в начале не копил за собой все остальные
+        while (!free_slots.empty() && next_file < paths.size() &&
+               next_file - next_deliver < queue_depth * 2) {
+            io_uring_sqe* sqe = uring_get_sqe(ring);
+            if (sqe == nullptr) break;
+
+            size_t slot_id = free_slots.back();
+            free_slots.pop_back();
+            UringSlot& slot = slots[slot_id];
+            slot.index = next_file;
+            slot.fd = -1;
+            slot.stage = STAGE_OPEN;
+            slot.length = 0;
+            slot.failed = false;
+            slot.data.assign(URING_INITIAL_BUFFER, '\0');
+
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)paths[next_file].c_str();
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = slot_id;
+
+            next_file++;
+        }
+
+        if (free_slots.size() < queue_depth || ring.to_submit > 0) {
+            if (!uring_submit_and_wait(ring)) {
+                // Уже отданные файлы учтены, остальные дочитает вызывающий.
+                // Отменяемые ядром чтения ещё могут писать в буферы слотов,
+                // поэтому буферы намеренно не освобождаются
+                cerr << "Ошибка io_uring: " << strerror(errno) << ", дочитываем с файла " << next_deliver << endl;
+                for (UringSlot& slot : slots) {
+                    if (slot.stage == STAGE_READ && slot.fd >= 0) close(slot.fd);
+                }
+                new vector<UringSlot>(move(slots));
+                uring_close(ring);
+                delivered = next_deliver;
+                return true;
+            }
+        }
+
+        // Разбираем завершённые операции
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+            size_t slot_id = (size_t)cqe->user_data;
+            int res = cqe->res;
+            head++;
+
+            UringSlot& slot = slots[slot_id];
+            bool finished = false;
+
+            if (slot.stage == STAGE_OPEN) {
+                if (res < 0) {
+                    cerr << "Предупреждение: не могу открыть файл " << paths[slot.index]
+                         << ": " << strerror(-res) << endl;
+                    slot.failed = true;
+                    finished = true;
+                } else {
+                    slot.fd = res;
+                    prep_read(ring, slot, slot_id);
+                }
+            }
+            else if (slot.stage == STAGE_READ) {
+                if (res < 0) {
+                    cerr << "Предупреждение: ошибка чтения файла " << paths[slot.index]
+                         << ": " << strerror(-res) << endl;
+                    slot.failed = true;
+                    prep_close(ring, slot, slot_id);
+                } else {
+                    size_t requested = slot.data.size() - slot.length;
+                    slot.length += res;
+                    // Буфер заполнен целиком - возможно, файл длиннее, читаем дальше.
+                    // Короткое чтение обычного файла означает конец файла
+                    if (res > 0 && (size_t)res == requested) {
+                        prep_read(ring, slot, slot_id);
+                    } else {
+                        prep_close(ring, slot, slot_id);
+                    }
+                }
+            }
+            else {
+                finished = true;
+            }
+
+            if (finished) {
+                string contents;
+                if (!slot.failed) {
+                    slot.data.resize(slot.length);
+                    contents.swap(slot.data);
+                }
+                completed[slot.index] = move(contents);
+                slot.fd = -1;
+                free_slots.push_back(slot_id);
+            }
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+        // Отдаём готовые файлы строго по порядку
+        auto it = completed.find(next_deliver);
+        while (it != completed.end()) {
+            on_file(next_deliver, it->second);
+            completed.erase(it);
+            next_deliver++;
+            delivered = next_deliver;
+            it = completed.find(next_deliver);
+        }
+    }
+
+    uring_close(ring);
+    return true;
+}
+
+#else
+
+bool uring_available() {
+    return false;
+}
+
+bool uring_read_files(const vector<string>&, size_t,
+                      const function<void(size_t index, string& contents)>&, size_t& delivered) {
+    delivered = 0;
+    return false;
+}
+
+#endif
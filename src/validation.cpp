@@ -0,0 +1,192 @@
+#include "../include/validation.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+
+// Частичный результат одного диапазона заказов
+struct ValidationPart {
+    long long counts[ERR_CODE_COUNT];
+    vector<ValidationError> sample;
+};
+
+// Проверить заказы [begin, end); shared_total - общий счётчик ошибок для --max-errors
+static void validate_range(const vector<Order>& orders, size_t begin, size_t end,
+                           const ValidationOptions& options, atomic<long long>& shared_total,
+                           ValidationPart& part) {
+    for (int k = 0; k < ERR_CODE_COUNT; k++) {
+        part.counts[k] = 0;
+    }
+
+    long long local_errors = 0;
+
+    // Проверяем только поля, которые парсер действительно читал
+    bool check_id = (options.fields & FIELD_ID) != 0;
+    bool check_ts = (options.fields & FIELD_TS) != 0;
+    bool check_items = (options.fields & FIELDS_ITEM) != 0;
+    bool check_sku = (options.fields & FIELD_SKU) != 0;
+    bool check_qty = (options.fields & FIELD_QTY) != 0;
+    bool check_price = (options.fields & FIELD_PRICE) != 0;
+
+    // Учесть ошибку: посчитать и, пока есть место, сохранить образец
+    auto report = [&](size_t i, int j, ValidationErrorCode code) {
+        part.counts[code]++;
+        local_errors++;
+        if (part.sample.size() < options.sample_size) {
+            part.sample.push_back({(uint32_t)i, (int32_t)j, code});
+        }
+    };
+
+    for (size_t i = begin; i < end; i++) {
+        const Order& order = orders[i];
+
+        // Проверки заказа
+        if (check_id && order.id.empty()) report(i, -1, ERR_EMPTY_ID);
+        if (check_ts && order.date_time.length() < 10) report(i, -1, ERR_BAD_DATE);
+        if (check_items && order.items.empty()) report(i, -1, ERR_NO_ITEMS);
+
+        // Проверки каждого товара
+        for (size_t j = 0; j < order.items.size(); j++) {
+            const Item& item = order.items[j];
+
+            if (check_sku && !item_has_sku(item)) report(i, (int)j, ERR_EMPTY_SKU);
+            if (check_qty && item.quantity <= 0) report(i, (int)j, ERR_BAD_QUANTITY);
+            if (check_price && item.price < 0) report(i, (int)j, ERR_NEGATIVE_PRICE);
+        }
+
+        // Публикуем найденные ошибки и проверяем лимит после каждого заказа
+        if (local_errors > 0) {
+            long long total = shared_total.fetch_add(local_errors) + local_errors;
+            local_errors = 0;
+            if (options.max_errors > 0 && total >= (long long)options.max_errors) {
+                return;
+            }
+        }
+        else if (options.max_errors > 0 && shared_total.load(memory_order_relaxed) >= (long long)options.max_errors) {
+            return;
+        }
+    }
+}
+
+ValidationResult validate_orders(const vector<Order>& orders, const ValidationOptions& options) {
+    // Число потоков: не больше, чем нужно для этого объёма
+    size_t thread_count = options.threads > 1 ? (size_t)options.threads : 1;
+    thread_count = min(thread_count, max<size_t>(1, orders.size() / MIN_ORDERS_PER_THREAD));
+
+    vector<ValidationPart> parts(thread_count);
+    atomic<long long> shared_total(0);
+
+    size_t chunk = (orders.size() + thread_count - 1) / thread_count;
+
+    if (thread_count == 1) {
+        validate_range(orders, 0, orders.size(), options, shared_total, parts[0]);
+    }
+    else {
+        vector<thread> workers;
+        for (size_t t = 0; t < thread_count; t++) {
+            size_t begin = min(orders.size(), t * chunk);
+            size_t end = min(orders.size(), begin + chunk);
+            workers.emplace_back(validate_range, cref(orders), begin, end, cref(options),
+                                 ref(shared_total), ref(parts[t]));
+        }
+        for (thread& w : workers) {
+            w.join();
+        }
+    }
+
+    // Склеиваем диапазоны по порядку: образец остаётся отсортированным по заказам
+    ValidationResult result;
+    result.total = 0;
+    for (int k = 0; k < ERR_CODE_COUNT; k++) {
+        result.counts[k] = 0;
+    }
+
+    for (const ValidationPart& part : parts) {
+        for (int k = 0; k < ERR_CODE_COUNT; k++) {
+            result.counts[k] += part.counts[k];
+            result.total += part.counts[k];
+        }
+        for (const ValidationError& e : part.sample) {
+            if (result.sample.size() >= options.sample_size) break;
+            result.sample.push_back(e);
+        }
+    }
+
+    result.stopped_early = options.max_errors > 0 && result.total >= (long long)options.max_errors;
+
+    return result;
+}
+
+const char* validation_error_name(ValidationErrorCode code) {
+    switch (code) {
+        case ERR_EMPTY_ID:       return "пустой ID";
+        case ERR_BAD_DATE:       return "неправильная дата";
+        case ERR_NO_ITEMS:       return "нет товаров";
+        case ERR_EMPTY_SKU:      return "пустой артикул";
+        case ERR_BAD_QUANTITY:   return "количество должно быть > 0";
+        case ERR_NEGATIVE_PRICE: return "цена не может быть отрицательной";
+        default:                 return "неизвестная ошибка";
+    }
+}
+
+// order_at(номер) - заказ из образца ошибок
+template <typename OrderAt>
+static void print_result(OrderAt order_at, const ValidationResult& result) {
+    ostringstream out;
+
+    // Образец ошибок в прежнем формате сообщений
+    for (const ValidationError& e : result.sample) {
+        const Order& order = order_at(e.order_index);
+
+        out << "  Ошибка в заказе #" << e.order_index;
+        if (e.item_index < 0) {
+            if (e.code != ERR_EMPTY_ID && !order.id.empty()) {
+                out << " (ID: " << order.id << ")";
+            }
+        }
+        else {
+            const Item& item = order.items[e.item_index];
+            out << ", товар #" << e.item_index;
+            if (item_has_sku(item)) {
+                out << " (" << item_sku(order, item) << ")";
+            }
+        }
+        out << ": " << validation_error_name(e.code) << "\n";
+    }
+
+    if (result.total > (long long)result.sample.size()) {
+        out << "  ... и ещё " << (result.total - (long long)result.sample.size())
+            << " ошибок не показано\n";
+    }
+
+    if (result.total == 0) {
+        out << "\nВсе данные правильные!\n";
+    }
+    else {
+        out << "\nОшибки по типам:\n";
+        for (int k = 0; k < ERR_CODE_COUNT; k++) {
+            if (result.counts[k] == 0) continue;
+            out << "  " << validation_error_name((ValidationErrorCode)k) << ": " << result.counts[k] << "\n";
+        }
+
+        out << "\nНайдено ошибок: " << result.total;
+        if (result.stopped_early) {
+            out << " (проверка остановлена по лимиту --max-errors)";
+        }
+        out << "\n";
+    }
+
+    cout << out.str();
+    cout.flush();
+}
+
+void print_validation_result(const vector<Order>& orders, const ValidationResult& result) {
+    print_result([&orders](size_t index) -> const Order& { return orders[index]; }, result);
+}
+
+void print_validation_result(const map<size_t, Order>& orders, const ValidationResult& result) {
+    print_result([&orders](size_t index) -> const Order& { return orders.at(index); }, result);
+}